@@ -78,13 +78,14 @@ typedef struct
 
 struct LocApiMsg: LocMsg {
     private:
-        std::function<void ()> mProcImpl;
+        LocTask mProcImpl;
         inline virtual void proc() const {
             mProcImpl();
         }
     public:
-        inline LocApiMsg(std::function<void ()> procImpl ) :
-                         mProcImpl(procImpl) {}
+        template <typename F>
+        inline LocApiMsg(F&& procImpl ) :
+                         mProcImpl(std::forward<F>(procImpl)) {}
 };
 
 class LocApiProxyBase {
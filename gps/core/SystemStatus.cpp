@@ -30,6 +30,7 @@
 
 #include <inttypes.h>
 #include <string>
+#include <unordered_map>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/time.h>
@@ -51,36 +52,70 @@ namespace loc_core
 class SystemStatusNmeaBase
 {
 protected:
-    std::vector<std::string> mField;
+    // PQWP7 has the most fields
+    static const uint32_t NMEA_MAX_FIELDS = 2 + SV_ALL_NUM * 3;
 
-    SystemStatusNmeaBase(const char *str_in, uint32_t len_in)
+    // One field of the sentence, a view into the caller's buffer. A field is
+    // always followed by ',' or '*', which ends the numbers parsed from it.
+    class Field
     {
-        // check size and talker
-        if (!loc_nmea_is_debug(str_in, len_in)) {
-            return;
+        const char* mStr;
+        uint32_t mLen;
+    public:
+        inline Field(const char* str, uint32_t len) : mStr(str), mLen(len) {}
+        inline const char* data() const { return mStr; }
+        inline uint32_t size() const { return mLen; }
+        inline int toInt() const { return atoi(mStr); }
+        inline long toHex() const { return strtol(mStr, NULL, 16); }
+        inline unsigned long long toU64() const { return strtoull(mStr, nullptr, 10); }
+        inline double toDouble() const { return atof(mStr); }
+    };
+
+    // Fields of the sentence, found in a single pass without copying it
+    class Fields
+    {
+        const char* mStr;
+        uint32_t mCount;
+        // mStart[i] is the offset of field i, mStart[mCount] is one past
+        // the delimiter of the last field
+        uint16_t mStart[NMEA_MAX_FIELDS + 1];
+    public:
+        inline Fields() : mStr(NULL), mCount(0) { mStart[0] = 0; }
+        void tokenize(const char *str_in, uint32_t len_in)
+        {
+            // the fields end with the '*' of the checksum
+            const char* end = (const char*)memchr(str_in, '*', strnlen(str_in, len_in));
+            if (NULL == end) {
+                return;
+            }
+            mStr = str_in;
+            const char* p = str_in;
+            while (mCount < NMEA_MAX_FIELDS) {
+                const char* comma = (const char*)memchr(p, ',', end - p);
+                const char* next = (NULL == comma) ? end : comma;
+                mStart[mCount++] = (uint16_t)(p - str_in);
+                p = next + 1;
+                if (next == end) {
+                    break;
+                }
+            }
+            mStart[mCount] = (uint16_t)(p - str_in);
+        }
+        inline size_t size() const { return mCount; }
+        inline Field operator[](size_t i) const {
+            return Field(mStr + mStart[i], mStart[i + 1] - mStart[i] - 1);
         }
+    };
 
-        std::string parser(str_in);
-        std::string::size_type index = 0;
+    Fields mField;
 
-        // verify checksum field
-        index = parser.find("*");
-        if (index == std::string::npos) {
+    SystemStatusNmeaBase(const char *str_in, uint32_t len_in)
+    {
+        // check size and talker
+        if (!loc_nmea_is_debug(str_in, len_in)) {
             return;
         }
-        parser[index] = ',';
-
-        // tokenize parser
-        while (1) {
-            std::string str;
-            index = parser.find(",");
-            if (index == std::string::npos) {
-                break;
-            }
-            str = parser.substr(0, index);
-            parser = parser.substr(index + 1);
-            mField.push_back(str);
-        }
+        mField.tokenize(str_in, len_in);
     }
 
     virtual ~SystemStatusNmeaBase() { }
@@ -214,42 +249,42 @@ public:
             mM1.mTimeValid = 0;
             return;
         }
-        mM1.mGpsWeek = atoi(mField[eGpsWeek].c_str());
-        mM1.mGpsTowMs = atoi(mField[eGpsTowMs].c_str());
-        mM1.mTimeValid = atoi(mField[eTimeValid].c_str());
-        mM1.mTimeSource = atoi(mField[eTimeSource].c_str());
-        mM1.mTimeUnc = atoi(mField[eTimeUnc].c_str());
-        mM1.mClockFreqBias = atoi(mField[eClockFreqBias].c_str());
-        mM1.mClockFreqBiasUnc = atoi(mField[eClockFreqBiasUnc].c_str());
-        mM1.mXoState = atoi(mField[eXoState].c_str());
-        mM1.mPgaGain = atoi(mField[ePgaGain].c_str());
-        mM1.mGpsBpAmpI = atoi(mField[eGpsBpAmpI].c_str());
-        mM1.mGpsBpAmpQ = atoi(mField[eGpsBpAmpQ].c_str());
-        mM1.mAdcI = atoi(mField[eAdcI].c_str());
-        mM1.mAdcQ = atoi(mField[eAdcQ].c_str());
-        mM1.mJammerGps = atoi(mField[eJammerGps].c_str());
-        mM1.mJammerGlo = atoi(mField[eJammerGlo].c_str());
-        mM1.mJammerBds = atoi(mField[eJammerBds].c_str());
-        mM1.mJammerGal = atoi(mField[eJammerGal].c_str());
-        mM1.mRecErrorRecovery = atoi(mField[eRecErrorRecovery].c_str());
-        mM1.mAgcGps = atof(mField[eAgcGps].c_str());
-        mM1.mAgcGlo = atof(mField[eAgcGlo].c_str());
-        mM1.mAgcBds = atof(mField[eAgcBds].c_str());
-        mM1.mAgcGal = atof(mField[eAgcGal].c_str());
+        mM1.mGpsWeek = mField[eGpsWeek].toInt();
+        mM1.mGpsTowMs = mField[eGpsTowMs].toInt();
+        mM1.mTimeValid = mField[eTimeValid].toInt();
+        mM1.mTimeSource = mField[eTimeSource].toInt();
+        mM1.mTimeUnc = mField[eTimeUnc].toInt();
+        mM1.mClockFreqBias = mField[eClockFreqBias].toInt();
+        mM1.mClockFreqBiasUnc = mField[eClockFreqBiasUnc].toInt();
+        mM1.mXoState = mField[eXoState].toInt();
+        mM1.mPgaGain = mField[ePgaGain].toInt();
+        mM1.mGpsBpAmpI = mField[eGpsBpAmpI].toInt();
+        mM1.mGpsBpAmpQ = mField[eGpsBpAmpQ].toInt();
+        mM1.mAdcI = mField[eAdcI].toInt();
+        mM1.mAdcQ = mField[eAdcQ].toInt();
+        mM1.mJammerGps = mField[eJammerGps].toInt();
+        mM1.mJammerGlo = mField[eJammerGlo].toInt();
+        mM1.mJammerBds = mField[eJammerBds].toInt();
+        mM1.mJammerGal = mField[eJammerGal].toInt();
+        mM1.mRecErrorRecovery = mField[eRecErrorRecovery].toInt();
+        mM1.mAgcGps = mField[eAgcGps].toDouble();
+        mM1.mAgcGlo = mField[eAgcGlo].toDouble();
+        mM1.mAgcBds = mField[eAgcBds].toDouble();
+        mM1.mAgcGal = mField[eAgcGal].toDouble();
         if (mField.size() > eLeapSecUnc) {
-            mM1.mLeapSeconds = atoi(mField[eLeapSeconds].c_str());
-            mM1.mLeapSecUnc = atoi(mField[eLeapSecUnc].c_str());
+            mM1.mLeapSeconds = mField[eLeapSeconds].toInt();
+            mM1.mLeapSecUnc = mField[eLeapSecUnc].toInt();
         }
         if (mField.size() > eGalBpAmpQ) {
-            mM1.mGloBpAmpI = atoi(mField[eGloBpAmpI].c_str());
-            mM1.mGloBpAmpQ = atoi(mField[eGloBpAmpQ].c_str());
-            mM1.mBdsBpAmpI = atoi(mField[eBdsBpAmpI].c_str());
-            mM1.mBdsBpAmpQ = atoi(mField[eBdsBpAmpQ].c_str());
-            mM1.mGalBpAmpI = atoi(mField[eGalBpAmpI].c_str());
-            mM1.mGalBpAmpQ = atoi(mField[eGalBpAmpQ].c_str());
+            mM1.mGloBpAmpI = mField[eGloBpAmpI].toInt();
+            mM1.mGloBpAmpQ = mField[eGloBpAmpQ].toInt();
+            mM1.mBdsBpAmpI = mField[eBdsBpAmpI].toInt();
+            mM1.mBdsBpAmpQ = mField[eBdsBpAmpQ].toInt();
+            mM1.mGalBpAmpI = mField[eGalBpAmpI].toInt();
+            mM1.mGalBpAmpQ = mField[eGalBpAmpQ].toInt();
         }
         if (mField.size() > eTimeUncNs) {
-            mM1.mTimeUncNs = strtoull(mField[eTimeUncNs].c_str(), nullptr, 10);
+            mM1.mTimeUncNs = mField[eTimeUncNs].toU64();
         }
     }
 
@@ -305,13 +340,13 @@ public:
             return;
         }
         memset(&mP1, 0, sizeof(mP1));
-        mP1.mEpiValidity = strtol(mField[eEpiValidity].c_str(), NULL, 16);
-        mP1.mEpiLat = atof(mField[eEpiLat].c_str());
-        mP1.mEpiLon = atof(mField[eEpiLon].c_str());
-        mP1.mEpiAlt = atof(mField[eEpiAlt].c_str());
-        mP1.mEpiHepe = atoi(mField[eEpiHepe].c_str());
-        mP1.mEpiAltUnc = atof(mField[eEpiAltUnc].c_str());
-        mP1.mEpiSrc = atoi(mField[eEpiSrc].c_str());
+        mP1.mEpiValidity = mField[eEpiValidity].toHex();
+        mP1.mEpiLat = mField[eEpiLat].toDouble();
+        mP1.mEpiLon = mField[eEpiLon].toDouble();
+        mP1.mEpiAlt = mField[eEpiAlt].toDouble();
+        mP1.mEpiHepe = mField[eEpiHepe].toInt();
+        mP1.mEpiAltUnc = mField[eEpiAltUnc].toDouble();
+        mP1.mEpiSrc = mField[eEpiSrc].toInt();
     }
 
     inline SystemStatusPQWP1& get() { return mP1;}
@@ -360,11 +395,11 @@ public:
             return;
         }
         memset(&mP2, 0, sizeof(mP2));
-        mP2.mBestLat = atof(mField[eBestLat].c_str());
-        mP2.mBestLon = atof(mField[eBestLon].c_str());
-        mP2.mBestAlt = atof(mField[eBestAlt].c_str());
-        mP2.mBestHepe = atof(mField[eBestHepe].c_str());
-        mP2.mBestAltUnc = atof(mField[eBestAltUnc].c_str());
+        mP2.mBestLat = mField[eBestLat].toDouble();
+        mP2.mBestLon = mField[eBestLon].toDouble();
+        mP2.mBestAlt = mField[eBestAlt].toDouble();
+        mP2.mBestHepe = mField[eBestHepe].toDouble();
+        mP2.mBestAltUnc = mField[eBestAltUnc].toDouble();
     }
 
     inline SystemStatusPQWP2& get() { return mP2;}
@@ -437,17 +472,17 @@ public:
         }
         memset(&mP3, 0, sizeof(mP3));
         // todo: update for navic once available
-        mP3.mXtraValidMask = strtol(mField[eXtraValidMask].c_str(), NULL, 16);
-        mP3.mGpsXtraAge = atoi(mField[eGpsXtraAge].c_str());
-        mP3.mGloXtraAge = atoi(mField[eGloXtraAge].c_str());
-        mP3.mBdsXtraAge = atoi(mField[eBdsXtraAge].c_str());
-        mP3.mGalXtraAge = atoi(mField[eGalXtraAge].c_str());
-        mP3.mQzssXtraAge = atoi(mField[eQzssXtraAge].c_str());
-        mP3.mGpsXtraValid = strtol(mField[eGpsXtraValid].c_str(), NULL, 16);
-        mP3.mGloXtraValid = strtol(mField[eGloXtraValid].c_str(), NULL, 16);
-        mP3.mBdsXtraValid = strtol(mField[eBdsXtraValid].c_str(), NULL, 16);
-        mP3.mGalXtraValid = strtol(mField[eGalXtraValid].c_str(), NULL, 16);
-        mP3.mQzssXtraValid = strtol(mField[eQzssXtraValid].c_str(), NULL, 16);
+        mP3.mXtraValidMask = mField[eXtraValidMask].toHex();
+        mP3.mGpsXtraAge = mField[eGpsXtraAge].toInt();
+        mP3.mGloXtraAge = mField[eGloXtraAge].toInt();
+        mP3.mBdsXtraAge = mField[eBdsXtraAge].toInt();
+        mP3.mGalXtraAge = mField[eGalXtraAge].toInt();
+        mP3.mQzssXtraAge = mField[eQzssXtraAge].toInt();
+        mP3.mGpsXtraValid = mField[eGpsXtraValid].toHex();
+        mP3.mGloXtraValid = mField[eGloXtraValid].toHex();
+        mP3.mBdsXtraValid = mField[eBdsXtraValid].toHex();
+        mP3.mGalXtraValid = mField[eGalXtraValid].toHex();
+        mP3.mQzssXtraValid = mField[eQzssXtraValid].toHex();
     }
 
     inline SystemStatusPQWP3& get() { return mP3;}
@@ -496,11 +531,11 @@ public:
             return;
         }
         memset(&mP4, 0, sizeof(mP4));
-        mP4.mGpsEpheValid = strtol(mField[eGpsEpheValid].c_str(), NULL, 16);
-        mP4.mGloEpheValid = strtol(mField[eGloEpheValid].c_str(), NULL, 16);
-        mP4.mBdsEpheValid = strtol(mField[eBdsEpheValid].c_str(), NULL, 16);
-        mP4.mGalEpheValid = strtol(mField[eGalEpheValid].c_str(), NULL, 16);
-        mP4.mQzssEpheValid = strtol(mField[eQzssEpheValid].c_str(), NULL, 16);
+        mP4.mGpsEpheValid = mField[eGpsEpheValid].toHex();
+        mP4.mGloEpheValid = mField[eGloEpheValid].toHex();
+        mP4.mBdsEpheValid = mField[eBdsEpheValid].toHex();
+        mP4.mGalEpheValid = mField[eGalEpheValid].toHex();
+        mP4.mQzssEpheValid = mField[eQzssEpheValid].toHex();
     }
 
     inline SystemStatusPQWP4& get() { return mP4;}
@@ -587,21 +622,21 @@ public:
         }
         memset(&mP5, 0, sizeof(mP5));
         // todo: update for navic once available
-        mP5.mGpsUnknownMask = strtol(mField[eGpsUnknownMask].c_str(), NULL, 16);
-        mP5.mGloUnknownMask = strtol(mField[eGloUnknownMask].c_str(), NULL, 16);
-        mP5.mBdsUnknownMask = strtol(mField[eBdsUnknownMask].c_str(), NULL, 16);
-        mP5.mGalUnknownMask = strtol(mField[eGalUnknownMask].c_str(), NULL, 16);
-        mP5.mQzssUnknownMask = strtol(mField[eQzssUnknownMask].c_str(), NULL, 16);
-        mP5.mGpsGoodMask = strtol(mField[eGpsGoodMask].c_str(), NULL, 16);
-        mP5.mGloGoodMask = strtol(mField[eGloGoodMask].c_str(), NULL, 16);
-        mP5.mBdsGoodMask = strtol(mField[eBdsGoodMask].c_str(), NULL, 16);
-        mP5.mGalGoodMask = strtol(mField[eGalGoodMask].c_str(), NULL, 16);
-        mP5.mQzssGoodMask = strtol(mField[eQzssGoodMask].c_str(), NULL, 16);
-        mP5.mGpsBadMask = strtol(mField[eGpsBadMask].c_str(), NULL, 16);
-        mP5.mGloBadMask = strtol(mField[eGloBadMask].c_str(), NULL, 16);
-        mP5.mBdsBadMask = strtol(mField[eBdsBadMask].c_str(), NULL, 16);
-        mP5.mGalBadMask = strtol(mField[eGalBadMask].c_str(), NULL, 16);
-        mP5.mQzssBadMask = strtol(mField[eQzssBadMask].c_str(), NULL, 16);
+        mP5.mGpsUnknownMask = mField[eGpsUnknownMask].toHex();
+        mP5.mGloUnknownMask = mField[eGloUnknownMask].toHex();
+        mP5.mBdsUnknownMask = mField[eBdsUnknownMask].toHex();
+        mP5.mGalUnknownMask = mField[eGalUnknownMask].toHex();
+        mP5.mQzssUnknownMask = mField[eQzssUnknownMask].toHex();
+        mP5.mGpsGoodMask = mField[eGpsGoodMask].toHex();
+        mP5.mGloGoodMask = mField[eGloGoodMask].toHex();
+        mP5.mBdsGoodMask = mField[eBdsGoodMask].toHex();
+        mP5.mGalGoodMask = mField[eGalGoodMask].toHex();
+        mP5.mQzssGoodMask = mField[eQzssGoodMask].toHex();
+        mP5.mGpsBadMask = mField[eGpsBadMask].toHex();
+        mP5.mGloBadMask = mField[eGloBadMask].toHex();
+        mP5.mBdsBadMask = mField[eBdsBadMask].toHex();
+        mP5.mGalBadMask = mField[eGalBadMask].toHex();
+        mP5.mQzssBadMask = mField[eQzssBadMask].toHex();
     }
 
     inline SystemStatusPQWP5& get() { return mP5;}
@@ -638,7 +673,7 @@ public:
             return;
         }
         memset(&mP6, 0, sizeof(mP6));
-        mP6.mFixInfoMask = strtol(mField[eFixInfoMask].c_str(), NULL, 16);
+        mP6.mFixInfoMask = mField[eFixInfoMask].toHex();
     }
 
     inline SystemStatusPQWP6& get() { return mP6;}
@@ -681,9 +716,9 @@ public:
 
         memset(mP7.mNav, 0, sizeof(mP7.mNav));
         for (uint32_t i=0; i<svLimit; i++) {
-            mP7.mNav[i].mType   = GnssEphemerisType(atoi(mField[i*3+2].c_str()));
-            mP7.mNav[i].mSource = GnssEphemerisSource(atoi(mField[i*3+3].c_str()));
-            mP7.mNav[i].mAgeSec = atoi(mField[i*3+4].c_str());
+            mP7.mNav[i].mType   = GnssEphemerisType(mField[i*3+2].toInt());
+            mP7.mNav[i].mSource = GnssEphemerisSource(mField[i*3+3].toInt());
+            mP7.mNav[i].mAgeSec = mField[i*3+4].toInt();
         }
     }
 
@@ -724,8 +759,8 @@ public:
             return;
         }
         memset(&mS1, 0, sizeof(mS1));
-        mS1.mFixInfoMask = atoi(mField[eFixInfoMask].c_str());
-        mS1.mHepeLimit = atoi(mField[eHepeLimit].c_str());
+        mS1.mFixInfoMask = mField[eFixInfoMask].toInt();
+        mS1.mHepeLimit = mField[eHepeLimit].toInt();
     }
 
     inline SystemStatusPQWS1& get() { return mS1;}
@@ -765,7 +800,7 @@ bool SystemStatusTimeAndClock::equals(const SystemStatusTimeAndClock& peer)
     return true;
 }
 
-void SystemStatusTimeAndClock::dump()
+void SystemStatusTimeAndClock::dump() const
 {
     LOC_LOGV("TimeAndClock: u=%ld:%ld g=%d:%d v=%d ts=%d tu=%d b=%d bu=%d ls=%d lu=%d un=%" PRIu64,
              mUtcTime.tv_sec, mUtcTime.tv_nsec,
@@ -798,7 +833,7 @@ bool SystemStatusXoState::equals(const SystemStatusXoState& peer)
     return true;
 }
 
-void SystemStatusXoState::dump()
+void SystemStatusXoState::dump() const
 {
     LOC_LOGV("XoState: u=%ld:%ld x=%d",
              mUtcTime.tv_sec, mUtcTime.tv_nsec,
@@ -858,7 +893,7 @@ bool SystemStatusRfAndParams::equals(const SystemStatusRfAndParams& peer)
     return true;
 }
 
-void SystemStatusRfAndParams::dump()
+void SystemStatusRfAndParams::dump() const
 {
     LOC_LOGV("RfAndParams: u=%ld:%ld p=%d bi=%d bq=%d ai=%d aq=%d "
              "jgp=%d jgl=%d jbd=%d jga=%d "
@@ -896,7 +931,7 @@ bool SystemStatusErrRecovery::equals(const SystemStatusErrRecovery& peer)
     return true;
 }
 
-void SystemStatusErrRecovery::dump()
+void SystemStatusErrRecovery::dump() const
 {
     LOC_LOGV("ErrRecovery: u=%ld:%ld e=%d",
              mUtcTime.tv_sec, mUtcTime.tv_nsec,
@@ -932,7 +967,7 @@ bool SystemStatusInjectedPosition::equals(const SystemStatusInjectedPosition& pe
     return true;
 }
 
-void SystemStatusInjectedPosition::dump()
+void SystemStatusInjectedPosition::dump() const
 {
     LOC_LOGV("InjectedPosition: u=%ld:%ld v=%x la=%f lo=%f al=%f he=%f au=%f es=%d",
              mUtcTime.tv_sec, mUtcTime.tv_nsec,
@@ -971,7 +1006,7 @@ bool SystemStatusBestPosition::equals(const SystemStatusBestPosition& peer)
     return true;
 }
 
-void SystemStatusBestPosition::dump()
+void SystemStatusBestPosition::dump() const
 {
     LOC_LOGV("BestPosition: u=%ld:%ld la=%f lo=%f al=%f he=%f au=%f",
              mUtcTime.tv_sec, mUtcTime.tv_nsec,
@@ -1023,7 +1058,7 @@ bool SystemStatusXtra::equals(const SystemStatusXtra& peer)
     return true;
 }
 
-void SystemStatusXtra::dump()
+void SystemStatusXtra::dump() const
 {
     LOC_LOGV("SystemStatusXtra: u=%ld:%ld m=%x a=%d:%d:%d:%d:%d v=%x:%x:%" PRIx64 ":%" PRIx64":%x",
              mUtcTime.tv_sec, mUtcTime.tv_nsec,
@@ -1065,7 +1100,7 @@ bool SystemStatusEphemeris::equals(const SystemStatusEphemeris& peer)
     return true;
 }
 
-void SystemStatusEphemeris::dump()
+void SystemStatusEphemeris::dump() const
 {
     LOC_LOGV("Ephemeris: u=%ld:%ld ev=%x:%x:%" PRIx64 ":%" PRIx64 ":%x",
              mUtcTime.tv_sec, mUtcTime.tv_nsec,
@@ -1124,7 +1159,7 @@ bool SystemStatusSvHealth::equals(const SystemStatusSvHealth& peer)
     return true;
 }
 
-void SystemStatusSvHealth::dump()
+void SystemStatusSvHealth::dump() const
 {
     LOC_LOGV("SvHealth: u=%ld:%ld \
              u=%x:%x:%" PRIx64 ":%" PRIx64 ":%x \
@@ -1165,7 +1200,7 @@ bool SystemStatusPdr::equals(const SystemStatusPdr& peer)
     return true;
 }
 
-void SystemStatusPdr::dump()
+void SystemStatusPdr::dump() const
 {
     LOC_LOGV("Pdr: u=%ld:%ld m=%x",
              mUtcTime.tv_sec, mUtcTime.tv_nsec,
@@ -1195,7 +1230,7 @@ bool SystemStatusNavData::equals(const SystemStatusNavData& peer)
     return true;
 }
 
-void SystemStatusNavData::dump()
+void SystemStatusNavData::dump() const
 {
     LOC_LOGV("NavData: u=%ld:%ld",
             mUtcTime.tv_sec, mUtcTime.tv_nsec);
@@ -1224,7 +1259,7 @@ bool SystemStatusPositionFailure::equals(const SystemStatusPositionFailure& peer
     return true;
 }
 
-void SystemStatusPositionFailure::dump()
+void SystemStatusPositionFailure::dump() const
 {
     LOC_LOGV("PositionFailure: u=%ld:%ld m=%d h=%d",
              mUtcTime.tv_sec, mUtcTime.tv_nsec,
@@ -1246,7 +1281,7 @@ bool SystemStatusLocation::equals(const SystemStatusLocation& peer)
     return true;
 }
 
-void SystemStatusLocation::dump()
+void SystemStatusLocation::dump() const
 {
     LOC_LOGV("Location: lat=%f lon=%f alt=%f spd=%f",
              mLocation.gpsLocation.latitude,
@@ -1357,17 +1392,14 @@ bool SystemStatus::setIteminReport(TYPE_REPORT& report, TYPE_ITEM&& s)
     if (s.ignore()) {
         return false;
     }
-    if (!report.empty() && report.back().equals(static_cast<TYPE_ITEM&>(s.collate(report.back())))) {
+    if (!report.empty() && static_cast<TYPE_ITEM&>(s.collate(report.back())).equals(report.back())) {
         // there is no change - just update reported timestamp
-        report.back().mUtcReported = s.mUtcReported;
+        report.writableBack().mUtcReported = s.mUtcReported;
         return false;
     }
 
-    // first event or updated
+    // first event or updated, the ring drops the oldest item once it holds maxItem
     report.push_back(s);
-    if (report.size() > s.maxItem) {
-        report.erase(report.begin());
-    }
     return true;
 }
 
@@ -1375,9 +1407,6 @@ template <typename TYPE_REPORT, typename TYPE_ITEM>
 void SystemStatus::setDefaultIteminReport(TYPE_REPORT& report, const TYPE_ITEM& s)
 {
     report.push_back(s);
-    if (report.size() > s.maxItem) {
-        report.erase(report.begin());
-    }
 }
 
 template <typename TYPE_REPORT, typename TYPE_ITEM>
@@ -1390,6 +1419,29 @@ void SystemStatus::getIteminReport(TYPE_REPORT& reportout, const TYPE_ITEM& c) c
     }
 }
 
+template <typename TYPE_ITEM, typename TYPE_BASE,
+          SystemStatusRing<TYPE_ITEM> SystemStatusReports::*REPORT>
+bool SystemStatus::setDataIteminReport(IDataItemCore* dataitem)
+{
+    return setIteminReport(mCache.*REPORT, TYPE_ITEM(*(static_cast<TYPE_BASE*>(dataitem))));
+}
+
+template <typename TYPE_ITEM, typename TYPE_PARSER,
+          SystemStatusRing<TYPE_ITEM> SystemStatusReports::*REPORT>
+void SystemStatus::setNmeainReport(const char* data, uint32_t len)
+{
+    setIteminReport(mCache.*REPORT, TYPE_ITEM(TYPE_PARSER(data, len).get()));
+}
+
+void SystemStatus::setPQWM1inReport(const char* data, uint32_t len)
+{
+    SystemStatusPQWM1 s = SystemStatusPQWM1parser(data, len).get();
+    setIteminReport(mCache.mTimeAndClock, SystemStatusTimeAndClock(s));
+    setIteminReport(mCache.mXoState, SystemStatusXoState(s));
+    setIteminReport(mCache.mRfAndParams, SystemStatusRfAndParams(s));
+    setIteminReport(mCache.mErrRecovery, SystemStatusErrRecovery(s));
+}
+
 /******************************************************************************
 @brief      API to set report data into internal buffer
 
@@ -1404,56 +1456,41 @@ bool SystemStatus::setNmeaString(const char *data, uint32_t len)
         return false;
     }
 
-    char buf[SystemStatusNmeaBase::NMEA_MAXSIZE + 1] = { 0 };
-    strlcpy(buf, data, sizeof(buf));
-
-    pthread_mutex_lock(&mMutexSystemStatus);
+    // the parser of each sentence, found by hashing its tag
+    static const std::unordered_map<uint64_t, NmeaHandler> sHandlers = {
+        { loc_nmea_debug_tag("$PQWM1"), &SystemStatus::setPQWM1inReport },
+        { loc_nmea_debug_tag("$PQWP1"), &SystemStatus::setNmeainReport<
+                SystemStatusInjectedPosition, SystemStatusPQWP1parser,
+                &SystemStatusReports::mInjectedPosition> },
+        { loc_nmea_debug_tag("$PQWP2"), &SystemStatus::setNmeainReport<
+                SystemStatusBestPosition, SystemStatusPQWP2parser,
+                &SystemStatusReports::mBestPosition> },
+        { loc_nmea_debug_tag("$PQWP3"), &SystemStatus::setNmeainReport<
+                SystemStatusXtra, SystemStatusPQWP3parser,
+                &SystemStatusReports::mXtra> },
+        { loc_nmea_debug_tag("$PQWP4"), &SystemStatus::setNmeainReport<
+                SystemStatusEphemeris, SystemStatusPQWP4parser,
+                &SystemStatusReports::mEphemeris> },
+        { loc_nmea_debug_tag("$PQWP5"), &SystemStatus::setNmeainReport<
+                SystemStatusSvHealth, SystemStatusPQWP5parser,
+                &SystemStatusReports::mSvHealth> },
+        { loc_nmea_debug_tag("$PQWP6"), &SystemStatus::setNmeainReport<
+                SystemStatusPdr, SystemStatusPQWP6parser,
+                &SystemStatusReports::mPdr> },
+        { loc_nmea_debug_tag("$PQWP7"), &SystemStatus::setNmeainReport<
+                SystemStatusNavData, SystemStatusPQWP7parser,
+                &SystemStatusReports::mNavData> },
+        { loc_nmea_debug_tag("$PQWS1"), &SystemStatus::setNmeainReport<
+                SystemStatusPositionFailure, SystemStatusPQWS1parser,
+                &SystemStatusReports::mPositionFailure> },
+    };
 
-    // parse the received nmea strings here
-    if (0 == strncmp(data, "$PQWM1", SystemStatusNmeaBase::NMEA_MINSIZE)) {
-        SystemStatusPQWM1 s = SystemStatusPQWM1parser(buf, len).get();
-        setIteminReport(mCache.mTimeAndClock, SystemStatusTimeAndClock(s));
-        setIteminReport(mCache.mXoState, SystemStatusXoState(s));
-        setIteminReport(mCache.mRfAndParams, SystemStatusRfAndParams(s));
-        setIteminReport(mCache.mErrRecovery, SystemStatusErrRecovery(s));
-    }
-    else if (0 == strncmp(data, "$PQWP1", SystemStatusNmeaBase::NMEA_MINSIZE)) {
-        setIteminReport(mCache.mInjectedPosition,
-                SystemStatusInjectedPosition(SystemStatusPQWP1parser(buf, len).get()));
-    }
-    else if (0 == strncmp(data, "$PQWP2", SystemStatusNmeaBase::NMEA_MINSIZE)) {
-        setIteminReport(mCache.mBestPosition,
-                SystemStatusBestPosition(SystemStatusPQWP2parser(buf, len).get()));
-    }
-    else if (0 == strncmp(data, "$PQWP3", SystemStatusNmeaBase::NMEA_MINSIZE)) {
-        setIteminReport(mCache.mXtra,
-                SystemStatusXtra(SystemStatusPQWP3parser(buf, len).get()));
-    }
-    else if (0 == strncmp(data, "$PQWP4", SystemStatusNmeaBase::NMEA_MINSIZE)) {
-        setIteminReport(mCache.mEphemeris,
-                SystemStatusEphemeris(SystemStatusPQWP4parser(buf, len).get()));
-    }
-    else if (0 == strncmp(data, "$PQWP5", SystemStatusNmeaBase::NMEA_MINSIZE)) {
-        setIteminReport(mCache.mSvHealth,
-                SystemStatusSvHealth(SystemStatusPQWP5parser(buf, len).get()));
-    }
-    else if (0 == strncmp(data, "$PQWP6", SystemStatusNmeaBase::NMEA_MINSIZE)) {
-        setIteminReport(mCache.mPdr,
-                SystemStatusPdr(SystemStatusPQWP6parser(buf, len).get()));
-    }
-    else if (0 == strncmp(data, "$PQWP7", SystemStatusNmeaBase::NMEA_MINSIZE)) {
-        setIteminReport(mCache.mNavData,
-                SystemStatusNavData(SystemStatusPQWP7parser(buf, len).get()));
-    }
-    else if (0 == strncmp(data, "$PQWS1", SystemStatusNmeaBase::NMEA_MINSIZE)) {
-        setIteminReport(mCache.mPositionFailure,
-                SystemStatusPositionFailure(SystemStatusPQWS1parser(buf, len).get()));
+    auto it = sHandlers.find(loc_nmea_debug_tag(data));
+    if (sHandlers.end() != it) {
+        pthread_mutex_lock(&mMutexSystemStatus);
+        (this->*(it->second))(data, len);
+        pthread_mutex_unlock(&mMutexSystemStatus);
     }
-    else {
-        // do nothing
-    }
-
-    pthread_mutex_unlock(&mMutexSystemStatus);
     return true;
 }
 
@@ -1490,102 +1527,94 @@ bool SystemStatus::eventPosition(const UlpLocation& location,
 ******************************************************************************/
 bool SystemStatus::eventDataItemNotify(IDataItemCore* dataitem)
 {
+    struct DataItemEntry {
+        DataItemId id;
+        DataItemHandler handler;
+    };
+    static const DataItemEntry sEntries[] = {
+        { AIRPLANEMODE_DATA_ITEM_ID,
+                &SystemStatus::setDataIteminReport<SystemStatusAirplaneMode, AirplaneModeDataItemBase,
+                        &SystemStatusReports::mAirplaneMode> },
+        { ENH_DATA_ITEM_ID,
+                &SystemStatus::setDataIteminReport<SystemStatusENH, ENHDataItemBase,
+                        &SystemStatusReports::mENH> },
+        { GPSSTATE_DATA_ITEM_ID,
+                &SystemStatus::setDataIteminReport<SystemStatusGpsState, GPSStateDataItemBase,
+                        &SystemStatusReports::mGPSState> },
+        { NLPSTATUS_DATA_ITEM_ID,
+                &SystemStatus::setDataIteminReport<SystemStatusNLPStatus, NLPStatusDataItemBase,
+                        &SystemStatusReports::mNLPStatus> },
+        { WIFIHARDWARESTATE_DATA_ITEM_ID,
+                &SystemStatus::setDataIteminReport<SystemStatusWifiHardwareState, WifiHardwareStateDataItemBase,
+                        &SystemStatusReports::mWifiHardwareState> },
+        { NETWORKINFO_DATA_ITEM_ID,
+                &SystemStatus::setDataIteminReport<SystemStatusNetworkInfo, NetworkInfoDataItemBase,
+                        &SystemStatusReports::mNetworkInfo> },
+        { RILSERVICEINFO_DATA_ITEM_ID,
+                &SystemStatus::setDataIteminReport<SystemStatusServiceInfo, RilServiceInfoDataItemBase,
+                        &SystemStatusReports::mRilServiceInfo> },
+        { RILCELLINFO_DATA_ITEM_ID,
+                &SystemStatus::setDataIteminReport<SystemStatusRilCellInfo, RilCellInfoDataItemBase,
+                        &SystemStatusReports::mRilCellInfo> },
+        { SERVICESTATUS_DATA_ITEM_ID,
+                &SystemStatus::setDataIteminReport<SystemStatusServiceStatus, ServiceStatusDataItemBase,
+                        &SystemStatusReports::mServiceStatus> },
+        { MODEL_DATA_ITEM_ID,
+                &SystemStatus::setDataIteminReport<SystemStatusModel, ModelDataItemBase,
+                        &SystemStatusReports::mModel> },
+        { MANUFACTURER_DATA_ITEM_ID,
+                &SystemStatus::setDataIteminReport<SystemStatusManufacturer, ManufacturerDataItemBase,
+                        &SystemStatusReports::mManufacturer> },
+        { ASSISTED_GPS_DATA_ITEM_ID,
+                &SystemStatus::setDataIteminReport<SystemStatusAssistedGps, AssistedGpsDataItemBase,
+                        &SystemStatusReports::mAssistedGps> },
+        { SCREEN_STATE_DATA_ITEM_ID,
+                &SystemStatus::setDataIteminReport<SystemStatusScreenState, ScreenStateDataItemBase,
+                        &SystemStatusReports::mScreenState> },
+        { POWER_CONNECTED_STATE_DATA_ITEM_ID,
+                &SystemStatus::setDataIteminReport<SystemStatusPowerConnectState, PowerConnectStateDataItemBase,
+                        &SystemStatusReports::mPowerConnectState> },
+        { TIMEZONE_CHANGE_DATA_ITEM_ID,
+                &SystemStatus::setDataIteminReport<SystemStatusTimeZoneChange, TimeZoneChangeDataItemBase,
+                        &SystemStatusReports::mTimeZoneChange> },
+        { TIME_CHANGE_DATA_ITEM_ID,
+                &SystemStatus::setDataIteminReport<SystemStatusTimeChange, TimeChangeDataItemBase,
+                        &SystemStatusReports::mTimeChange> },
+        { WIFI_SUPPLICANT_STATUS_DATA_ITEM_ID,
+                &SystemStatus::setDataIteminReport<SystemStatusWifiSupplicantStatus, WifiSupplicantStatusDataItemBase,
+                        &SystemStatusReports::mWifiSupplicantStatus> },
+        { SHUTDOWN_STATE_DATA_ITEM_ID,
+                &SystemStatus::setDataIteminReport<SystemStatusShutdownState, ShutdownStateDataItemBase,
+                        &SystemStatusReports::mShutdownState> },
+        { TAC_DATA_ITEM_ID,
+                &SystemStatus::setDataIteminReport<SystemStatusTac, TacDataItemBase,
+                        &SystemStatusReports::mTac> },
+        { MCCMNC_DATA_ITEM_ID,
+                &SystemStatus::setDataIteminReport<SystemStatusMccMnc, MccmncDataItemBase,
+                        &SystemStatusReports::mMccMnc> },
+        { BTLE_SCAN_DATA_ITEM_ID,
+                &SystemStatus::setDataIteminReport<SystemStatusBtDeviceScanDetail, BtDeviceScanDetailsDataItemBase,
+                        &SystemStatusReports::mBtDeviceScanDetail> },
+        { BT_SCAN_DATA_ITEM_ID,
+                &SystemStatus::setDataIteminReport<SystemStatusBtleDeviceScanDetail, BtLeDeviceScanDetailsDataItemBase,
+                        &SystemStatusReports::mBtLeDeviceScanDetail> },
+    };
+    // the handlers indexed by DataItemId
+    static const std::vector<DataItemHandler> sHandlers = [] {
+        std::vector<DataItemHandler> handlers(MAX_DATA_ITEM_ID, nullptr);
+        for (const DataItemEntry& entry : sEntries) {
+            handlers[entry.id] = entry.handler;
+        }
+        return handlers;
+    }();
+
     bool ret = false;
-    pthread_mutex_lock(&mMutexSystemStatus);
-    switch(dataitem->getId())
-    {
-        case AIRPLANEMODE_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mAirplaneMode,
-                    SystemStatusAirplaneMode(*(static_cast<AirplaneModeDataItemBase*>(dataitem))));
-            break;
-        case ENH_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mENH,
-                    SystemStatusENH(*(static_cast<ENHDataItemBase*>(dataitem))));
-            break;
-        case GPSSTATE_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mGPSState,
-                    SystemStatusGpsState(*(static_cast<GPSStateDataItemBase*>(dataitem))));
-            break;
-        case NLPSTATUS_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mNLPStatus,
-                    SystemStatusNLPStatus(*(static_cast<NLPStatusDataItemBase*>(dataitem))));
-            break;
-        case WIFIHARDWARESTATE_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mWifiHardwareState,
-                    SystemStatusWifiHardwareState(*(static_cast<WifiHardwareStateDataItemBase*>(dataitem))));
-            break;
-        case NETWORKINFO_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mNetworkInfo,
-                    SystemStatusNetworkInfo(*(static_cast<NetworkInfoDataItemBase*>(dataitem))));
-            break;
-        case RILSERVICEINFO_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mRilServiceInfo,
-                    SystemStatusServiceInfo(*(static_cast<RilServiceInfoDataItemBase*>(dataitem))));
-            break;
-        case RILCELLINFO_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mRilCellInfo,
-                    SystemStatusRilCellInfo(*(static_cast<RilCellInfoDataItemBase*>(dataitem))));
-            break;
-        case SERVICESTATUS_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mServiceStatus,
-                    SystemStatusServiceStatus(*(static_cast<ServiceStatusDataItemBase*>(dataitem))));
-            break;
-        case MODEL_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mModel,
-                    SystemStatusModel(*(static_cast<ModelDataItemBase*>(dataitem))));
-            break;
-        case MANUFACTURER_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mManufacturer,
-                    SystemStatusManufacturer(*(static_cast<ManufacturerDataItemBase*>(dataitem))));
-            break;
-        case ASSISTED_GPS_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mAssistedGps,
-                    SystemStatusAssistedGps(*(static_cast<AssistedGpsDataItemBase*>(dataitem))));
-            break;
-        case SCREEN_STATE_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mScreenState,
-                    SystemStatusScreenState(*(static_cast<ScreenStateDataItemBase*>(dataitem))));
-            break;
-        case POWER_CONNECTED_STATE_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mPowerConnectState,
-                    SystemStatusPowerConnectState(*(static_cast<PowerConnectStateDataItemBase*>(dataitem))));
-            break;
-        case TIMEZONE_CHANGE_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mTimeZoneChange,
-                    SystemStatusTimeZoneChange(*(static_cast<TimeZoneChangeDataItemBase*>(dataitem))));
-            break;
-        case TIME_CHANGE_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mTimeChange,
-                    SystemStatusTimeChange(*(static_cast<TimeChangeDataItemBase*>(dataitem))));
-            break;
-        case WIFI_SUPPLICANT_STATUS_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mWifiSupplicantStatus,
-                    SystemStatusWifiSupplicantStatus(*(static_cast<WifiSupplicantStatusDataItemBase*>(dataitem))));
-            break;
-        case SHUTDOWN_STATE_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mShutdownState,
-                    SystemStatusShutdownState(*(static_cast<ShutdownStateDataItemBase*>(dataitem))));
-            break;
-        case TAC_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mTac,
-                    SystemStatusTac(*(static_cast<TacDataItemBase*>(dataitem))));
-            break;
-        case MCCMNC_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mMccMnc,
-                    SystemStatusMccMnc(*(static_cast<MccmncDataItemBase*>(dataitem))));
-            break;
-        case BTLE_SCAN_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mBtDeviceScanDetail,
-                    SystemStatusBtDeviceScanDetail(*(static_cast<BtDeviceScanDetailsDataItemBase*>(dataitem))));
-            break;
-        case BT_SCAN_DATA_ITEM_ID:
-            ret = setIteminReport(mCache.mBtLeDeviceScanDetail,
-                    SystemStatusBtleDeviceScanDetail(*(static_cast<BtLeDeviceScanDetailsDataItemBase*>(dataitem))));
-            break;
-        default:
-            break;
+    DataItemId id = dataitem->getId();
+    if (id >= 0 && id < MAX_DATA_ITEM_ID && nullptr != sHandlers[id]) {
+        pthread_mutex_lock(&mMutexSystemStatus);
+        ret = (this->*sHandlers[id])(dataitem);
+        pthread_mutex_unlock(&mMutexSystemStatus);
     }
-    pthread_mutex_unlock(&mMutexSystemStatus);
     return ret;
 }
 
@@ -1599,49 +1628,54 @@ bool SystemStatus::eventDataItemNotify(IDataItemCore* dataitem)
 ******************************************************************************/
 bool SystemStatus::getReport(SystemStatusReports& report, bool isLatestOnly) const
 {
+    // the lock is only held to take a snapshot of the cache, whose rings share
+    // their items with the cache until the writers change them, so copying
+    // the latest items and dumping them does not block the writers
     pthread_mutex_lock(&mMutexSystemStatus);
+    const SystemStatusReports cache(mCache);
+    pthread_mutex_unlock(&mMutexSystemStatus);
 
     if (isLatestOnly) {
         // push back only the latest report and return it
-        getIteminReport(report.mLocation, mCache.mLocation);
-
-        getIteminReport(report.mTimeAndClock, mCache.mTimeAndClock);
-        getIteminReport(report.mXoState, mCache.mXoState);
-        getIteminReport(report.mRfAndParams, mCache.mRfAndParams);
-        getIteminReport(report.mErrRecovery, mCache.mErrRecovery);
-
-        getIteminReport(report.mInjectedPosition, mCache.mInjectedPosition);
-        getIteminReport(report.mBestPosition, mCache.mBestPosition);
-        getIteminReport(report.mXtra, mCache.mXtra);
-        getIteminReport(report.mEphemeris, mCache.mEphemeris);
-        getIteminReport(report.mSvHealth, mCache.mSvHealth);
-        getIteminReport(report.mPdr, mCache.mPdr);
-        getIteminReport(report.mNavData, mCache.mNavData);
-
-        getIteminReport(report.mPositionFailure, mCache.mPositionFailure);
-
-        getIteminReport(report.mAirplaneMode, mCache.mAirplaneMode);
-        getIteminReport(report.mENH, mCache.mENH);
-        getIteminReport(report.mGPSState, mCache.mGPSState);
-        getIteminReport(report.mNLPStatus, mCache.mNLPStatus);
-        getIteminReport(report.mWifiHardwareState, mCache.mWifiHardwareState);
-        getIteminReport(report.mNetworkInfo, mCache.mNetworkInfo);
-        getIteminReport(report.mRilServiceInfo, mCache.mRilServiceInfo);
-        getIteminReport(report.mRilCellInfo, mCache.mRilCellInfo);
-        getIteminReport(report.mServiceStatus, mCache.mServiceStatus);
-        getIteminReport(report.mModel, mCache.mModel);
-        getIteminReport(report.mManufacturer, mCache.mManufacturer);
-        getIteminReport(report.mAssistedGps, mCache.mAssistedGps);
-        getIteminReport(report.mScreenState, mCache.mScreenState);
-        getIteminReport(report.mPowerConnectState, mCache.mPowerConnectState);
-        getIteminReport(report.mTimeZoneChange, mCache.mTimeZoneChange);
-        getIteminReport(report.mTimeChange, mCache.mTimeChange);
-        getIteminReport(report.mWifiSupplicantStatus, mCache.mWifiSupplicantStatus);
-        getIteminReport(report.mShutdownState, mCache.mShutdownState);
-        getIteminReport(report.mTac, mCache.mTac);
-        getIteminReport(report.mMccMnc, mCache.mMccMnc);
-        getIteminReport(report.mBtDeviceScanDetail, mCache.mBtDeviceScanDetail);
-        getIteminReport(report.mBtLeDeviceScanDetail, mCache.mBtLeDeviceScanDetail);
+        getIteminReport(report.mLocation, cache.mLocation);
+
+        getIteminReport(report.mTimeAndClock, cache.mTimeAndClock);
+        getIteminReport(report.mXoState, cache.mXoState);
+        getIteminReport(report.mRfAndParams, cache.mRfAndParams);
+        getIteminReport(report.mErrRecovery, cache.mErrRecovery);
+
+        getIteminReport(report.mInjectedPosition, cache.mInjectedPosition);
+        getIteminReport(report.mBestPosition, cache.mBestPosition);
+        getIteminReport(report.mXtra, cache.mXtra);
+        getIteminReport(report.mEphemeris, cache.mEphemeris);
+        getIteminReport(report.mSvHealth, cache.mSvHealth);
+        getIteminReport(report.mPdr, cache.mPdr);
+        getIteminReport(report.mNavData, cache.mNavData);
+
+        getIteminReport(report.mPositionFailure, cache.mPositionFailure);
+
+        getIteminReport(report.mAirplaneMode, cache.mAirplaneMode);
+        getIteminReport(report.mENH, cache.mENH);
+        getIteminReport(report.mGPSState, cache.mGPSState);
+        getIteminReport(report.mNLPStatus, cache.mNLPStatus);
+        getIteminReport(report.mWifiHardwareState, cache.mWifiHardwareState);
+        getIteminReport(report.mNetworkInfo, cache.mNetworkInfo);
+        getIteminReport(report.mRilServiceInfo, cache.mRilServiceInfo);
+        getIteminReport(report.mRilCellInfo, cache.mRilCellInfo);
+        getIteminReport(report.mServiceStatus, cache.mServiceStatus);
+        getIteminReport(report.mModel, cache.mModel);
+        getIteminReport(report.mManufacturer, cache.mManufacturer);
+        getIteminReport(report.mAssistedGps, cache.mAssistedGps);
+        getIteminReport(report.mScreenState, cache.mScreenState);
+        getIteminReport(report.mPowerConnectState, cache.mPowerConnectState);
+        getIteminReport(report.mTimeZoneChange, cache.mTimeZoneChange);
+        getIteminReport(report.mTimeChange, cache.mTimeChange);
+        getIteminReport(report.mWifiSupplicantStatus, cache.mWifiSupplicantStatus);
+        getIteminReport(report.mShutdownState, cache.mShutdownState);
+        getIteminReport(report.mTac, cache.mTac);
+        getIteminReport(report.mMccMnc, cache.mMccMnc);
+        getIteminReport(report.mBtDeviceScanDetail, cache.mBtDeviceScanDetail);
+        getIteminReport(report.mBtLeDeviceScanDetail, cache.mBtLeDeviceScanDetail);
     }
     else {
         // copy entire reports and return them
@@ -1685,10 +1719,9 @@ bool SystemStatus::getReport(SystemStatusReports& report, bool isLatestOnly) con
         report.mBtDeviceScanDetail.clear();
         report.mBtLeDeviceScanDetail.clear();
 
-        report = mCache;
+        report = cache;
     }
 
-    pthread_mutex_unlock(&mMutexSystemStatus);
     return true;
 }
 
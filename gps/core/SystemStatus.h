@@ -34,6 +34,8 @@
 #include <vector>
 #include <algorithm>
 #include <iterator>
+#include <memory>
+#include <atomic>
 #include <loc_pla.h>
 #include <log_util.h>
 #include <MsgTask.h>
@@ -83,10 +85,10 @@ public:
         mUtcReported = mUtcTime;
     };
     virtual ~SystemStatusItemBase() {};
-    inline virtual SystemStatusItemBase& collate(SystemStatusItemBase&) {
+    inline virtual SystemStatusItemBase& collate(const SystemStatusItemBase&) {
         return *this;
     }
-    virtual void dump(void) {};
+    virtual void dump(void) const {};
     inline virtual bool ignore() { return false; };
 };
 
@@ -104,7 +106,7 @@ public:
         mLocation(location),
         mLocationEx(locationEx) {}
     bool equals(const SystemStatusLocation& peer);
-    void dump(void) override;
+    void dump(void) const override;
 };
 
 class SystemStatusPQWM1;
@@ -134,7 +136,7 @@ public:
         mTimeUncNs(0ULL) {}
     inline SystemStatusTimeAndClock(const SystemStatusPQWM1& nmea);
     bool equals(const SystemStatusTimeAndClock& peer);
-    void dump(void) override;
+    void dump(void) const override;
 };
 
 class SystemStatusXoState : public SystemStatusItemBase
@@ -145,7 +147,7 @@ public:
         mXoState(0) {}
     inline SystemStatusXoState(const SystemStatusPQWM1& nmea);
     bool equals(const SystemStatusXoState& peer);
-    void dump(void) override;
+    void dump(void) const override;
 };
 
 class SystemStatusRfAndParams : public SystemStatusItemBase
@@ -192,7 +194,7 @@ public:
         mGalBpAmpQ(0) {}
     inline SystemStatusRfAndParams(const SystemStatusPQWM1& nmea);
     bool equals(const SystemStatusRfAndParams& peer);
-    void dump(void) override;
+    void dump(void) const override;
 };
 
 class SystemStatusErrRecovery : public SystemStatusItemBase
@@ -204,7 +206,7 @@ public:
     inline SystemStatusErrRecovery(const SystemStatusPQWM1& nmea);
     bool equals(const SystemStatusErrRecovery& peer);
     inline bool ignore() override { return 0 == mRecErrorRecovery; };
-    void dump(void) override;
+    void dump(void) const override;
 };
 
 class SystemStatusPQWP1;
@@ -228,7 +230,7 @@ public:
         mEpiSrc(0) {}
     inline SystemStatusInjectedPosition(const SystemStatusPQWP1& nmea);
     bool equals(const SystemStatusInjectedPosition& peer);
-    void dump(void) override;
+    void dump(void) const override;
 };
 
 class SystemStatusPQWP2;
@@ -250,7 +252,7 @@ public:
         mBestAltUnc(0) {}
     inline SystemStatusBestPosition(const SystemStatusPQWP2& nmea);
     bool equals(const SystemStatusBestPosition& peer);
-    void dump(void) override;
+    void dump(void) const override;
 };
 
 class SystemStatusPQWP3;
@@ -286,7 +288,7 @@ public:
         mNavicXtraValid(0) {}
     inline SystemStatusXtra(const SystemStatusPQWP3& nmea);
     bool equals(const SystemStatusXtra& peer);
-    void dump(void) override;
+    void dump(void) const override;
 };
 
 class SystemStatusPQWP4;
@@ -306,7 +308,7 @@ public:
         mQzssEpheValid(0) {}
     inline SystemStatusEphemeris(const SystemStatusPQWP4& nmea);
     bool equals(const SystemStatusEphemeris& peer);
-    void dump(void) override;
+    void dump(void) const override;
 };
 
 class SystemStatusPQWP5;
@@ -352,7 +354,7 @@ public:
         mNavicBadMask(0) {}
     inline SystemStatusSvHealth(const SystemStatusPQWP5& nmea);
     bool equals(const SystemStatusSvHealth& peer);
-    void dump(void) override;
+    void dump(void) const override;
 };
 
 class SystemStatusPQWP6;
@@ -364,7 +366,7 @@ public:
         mFixInfoMask(0) {}
     inline SystemStatusPdr(const SystemStatusPQWP6& nmea);
     bool equals(const SystemStatusPdr& peer);
-    void dump(void) override;
+    void dump(void) const override;
 };
 
 class SystemStatusPQWP7;
@@ -388,7 +390,7 @@ public:
     }
     inline SystemStatusNavData(const SystemStatusPQWP7& nmea);
     bool equals(const SystemStatusNavData& peer);
-    void dump(void) override;
+    void dump(void) const override;
 };
 
 class SystemStatusPQWS1;
@@ -402,7 +404,7 @@ public:
         mHepeLimit(0) {}
     inline SystemStatusPositionFailure(const SystemStatusPQWS1& nmea);
     bool equals(const SystemStatusPositionFailure& peer);
-    void dump(void) override;
+    void dump(void) const override;
 };
 
 /******************************************************************************
@@ -445,7 +447,7 @@ public:
     inline bool equals(const SystemStatusGpsState& peer) {
         return (mEnabled == peer.mEnabled);
     }
-    inline void dump(void) override {
+    inline void dump(void) const override {
         LOC_LOGD("GpsState: state=%u", mEnabled);
     }
 };
@@ -510,12 +512,11 @@ public:
         }
         return rtv;
     }
-    inline virtual SystemStatusItemBase& collate(SystemStatusItemBase& curInfo) {
-        uint64_t allTypes = (static_cast<SystemStatusNetworkInfo&>(curInfo)).mAllTypes;
+    inline virtual SystemStatusItemBase& collate(const SystemStatusItemBase& curInfo) {
+        const SystemStatusNetworkInfo& cur = static_cast<const SystemStatusNetworkInfo&>(curInfo);
+        uint64_t allTypes = cur.mAllTypes;
         // Replace current with cached table for now and then update
-        memcpy(mAllNetworkHandles,
-               (static_cast<SystemStatusNetworkInfo&>(curInfo)).getNetworkHandle(),
-               sizeof(mAllNetworkHandles));
+        memcpy(mAllNetworkHandles, cur.mAllNetworkHandles, sizeof(mAllNetworkHandles));
         if (mConnected) {
             mAllTypes |= allTypes;
             for (uint8_t i = 0; i < MAX_NETWORK_HANDLES; ++i) {
@@ -576,7 +577,7 @@ public:
         }
         return *this;
     }
-    inline void dump(void) override {
+    inline void dump(void) const override {
         LOC_LOGD("NetworkInfo: mAllTypes=%" PRIx64 " connected=%u mType=%x",
                  mAllTypes, mConnected, mType);
     }
@@ -760,7 +761,7 @@ public:
     inline bool equals(const SystemStatusTac& peer) {
         return (mValue == peer.mValue);
     }
-    inline void dump(void) override {
+    inline void dump(void) const override {
         LOC_LOGD("Tac: value=%s", mValue.c_str());
     }
 };
@@ -776,7 +777,7 @@ public:
     inline bool equals(const SystemStatusMccMnc& peer) {
         return (mValue == peer.mValue);
     }
-    inline void dump(void) override {
+    inline void dump(void) const override {
         LOC_LOGD("TacMccMnc value=%s", mValue.c_str());
     }
 };
@@ -815,6 +816,91 @@ public:
     }
 };
 
+/******************************************************************************
+ SystemStatusRing - the latest items of a report, oldest first. Once the ring
+ is full, push_back() overwrites the oldest item instead of shifting them all.
+******************************************************************************/
+template <typename T, uint32_t N = SystemStatusItemBase::maxItem>
+class SystemStatusRing
+{
+    // copies of a ring share its items until one of them is changed, so that
+    // a copy, as handed out by getReport(), is an immutable snapshot which is
+    // taken by only counting a reference
+    struct Storage
+    {
+        std::vector<T> mItems;
+        uint32_t mFirst;    // index of the oldest item in mItems
+        inline Storage() : mFirst(0) {}
+    };
+    std::shared_ptr<Storage> mStorage;
+
+    inline const std::vector<T>& items() const {
+        static const std::vector<T> sNone;
+        return (nullptr == mStorage) ? sNone : mStorage->mItems;
+    }
+    inline uint32_t first() const {
+        return (nullptr == mStorage) ? 0 : mStorage->mFirst;
+    }
+    // storage that is not shared with any other copy of the ring
+    inline Storage& writable() {
+        if (nullptr == mStorage) {
+            mStorage = std::make_shared<Storage>();
+        } else if (mStorage.use_count() > 1) {
+            mStorage = std::make_shared<Storage>(*mStorage);
+        } else {
+            // pairs with the release of the last other copy
+            std::atomic_thread_fence(std::memory_order_acquire);
+        }
+        return *mStorage;
+    }
+
+    template <typename R, typename V>
+    class Iterator
+    {
+        R* mRing;
+        size_t mIndex;
+    public:
+        inline Iterator(R* ring, size_t index) : mRing(ring), mIndex(index) {}
+        inline V& operator*() const { return (*mRing)[mIndex]; }
+        inline V* operator->() const { return &(*mRing)[mIndex]; }
+        inline Iterator& operator++() { mIndex++; return *this; }
+        inline bool operator==(const Iterator& peer) const { return mIndex == peer.mIndex; }
+        inline bool operator!=(const Iterator& peer) const { return mIndex != peer.mIndex; }
+    };
+
+public:
+    typedef Iterator<const SystemStatusRing, const T> const_iterator;
+
+    inline bool empty() const { return items().empty(); }
+    inline size_t size() const { return items().size(); }
+    inline const T& operator[](size_t i) const { return items()[(first() + i) % N]; }
+    inline const T& front() const { return (*this)[0]; }
+    inline const T& back() const { return (*this)[size() - 1]; }
+    // the only accessor that may change an item in place, it unshares the ring
+    inline T& writableBack() {
+        Storage& s = writable();
+        return s.mItems[(s.mFirst + s.mItems.size() - 1) % N];
+    }
+    inline const_iterator begin() const { return const_iterator(this, 0); }
+    inline const_iterator end() const { return const_iterator(this, size()); }
+
+    inline void clear() {
+        mStorage.reset();
+    }
+    inline void push_back(const T& item) {
+        Storage& s = writable();
+        if (s.mItems.size() < N) {
+            if (s.mItems.capacity() < N) {
+                s.mItems.reserve(N);
+            }
+            s.mItems.push_back(item);
+        } else {
+            s.mItems[s.mFirst] = item;
+            s.mFirst = (s.mFirst + 1) % N;
+        }
+    }
+};
+
 /******************************************************************************
  SystemStatusReports
 ******************************************************************************/
@@ -822,49 +908,49 @@ class SystemStatusReports
 {
 public:
     // from QMI_LOC indication
-    std::vector<SystemStatusLocation>         mLocation;
+    SystemStatusRing<SystemStatusLocation>         mLocation;
 
     // from ME debug NMEA
-    std::vector<SystemStatusTimeAndClock>     mTimeAndClock;
-    std::vector<SystemStatusXoState>          mXoState;
-    std::vector<SystemStatusRfAndParams>      mRfAndParams;
-    std::vector<SystemStatusErrRecovery>      mErrRecovery;
+    SystemStatusRing<SystemStatusTimeAndClock>     mTimeAndClock;
+    SystemStatusRing<SystemStatusXoState>          mXoState;
+    SystemStatusRing<SystemStatusRfAndParams>      mRfAndParams;
+    SystemStatusRing<SystemStatusErrRecovery>      mErrRecovery;
 
     // from PE debug NMEA
-    std::vector<SystemStatusInjectedPosition> mInjectedPosition;
-    std::vector<SystemStatusBestPosition>     mBestPosition;
-    std::vector<SystemStatusXtra>             mXtra;
-    std::vector<SystemStatusEphemeris>        mEphemeris;
-    std::vector<SystemStatusSvHealth>         mSvHealth;
-    std::vector<SystemStatusPdr>              mPdr;
-    std::vector<SystemStatusNavData>          mNavData;
+    SystemStatusRing<SystemStatusInjectedPosition> mInjectedPosition;
+    SystemStatusRing<SystemStatusBestPosition>     mBestPosition;
+    SystemStatusRing<SystemStatusXtra>             mXtra;
+    SystemStatusRing<SystemStatusEphemeris>        mEphemeris;
+    SystemStatusRing<SystemStatusSvHealth>         mSvHealth;
+    SystemStatusRing<SystemStatusPdr>              mPdr;
+    SystemStatusRing<SystemStatusNavData>          mNavData;
 
     // from SM debug NMEA
-    std::vector<SystemStatusPositionFailure>  mPositionFailure;
+    SystemStatusRing<SystemStatusPositionFailure>  mPositionFailure;
 
     // from dataitems observer
-    std::vector<SystemStatusAirplaneMode>     mAirplaneMode;
-    std::vector<SystemStatusENH>              mENH;
-    std::vector<SystemStatusGpsState>         mGPSState;
-    std::vector<SystemStatusNLPStatus>        mNLPStatus;
-    std::vector<SystemStatusWifiHardwareState> mWifiHardwareState;
-    std::vector<SystemStatusNetworkInfo>      mNetworkInfo;
-    std::vector<SystemStatusServiceInfo>      mRilServiceInfo;
-    std::vector<SystemStatusRilCellInfo>      mRilCellInfo;
-    std::vector<SystemStatusServiceStatus>    mServiceStatus;
-    std::vector<SystemStatusModel>            mModel;
-    std::vector<SystemStatusManufacturer>     mManufacturer;
-    std::vector<SystemStatusAssistedGps>      mAssistedGps;
-    std::vector<SystemStatusScreenState>      mScreenState;
-    std::vector<SystemStatusPowerConnectState> mPowerConnectState;
-    std::vector<SystemStatusTimeZoneChange>   mTimeZoneChange;
-    std::vector<SystemStatusTimeChange>       mTimeChange;
-    std::vector<SystemStatusWifiSupplicantStatus> mWifiSupplicantStatus;
-    std::vector<SystemStatusShutdownState>    mShutdownState;
-    std::vector<SystemStatusTac>              mTac;
-    std::vector<SystemStatusMccMnc>           mMccMnc;
-    std::vector<SystemStatusBtDeviceScanDetail> mBtDeviceScanDetail;
-    std::vector<SystemStatusBtleDeviceScanDetail> mBtLeDeviceScanDetail;
+    SystemStatusRing<SystemStatusAirplaneMode>     mAirplaneMode;
+    SystemStatusRing<SystemStatusENH>              mENH;
+    SystemStatusRing<SystemStatusGpsState>         mGPSState;
+    SystemStatusRing<SystemStatusNLPStatus>        mNLPStatus;
+    SystemStatusRing<SystemStatusWifiHardwareState> mWifiHardwareState;
+    SystemStatusRing<SystemStatusNetworkInfo>      mNetworkInfo;
+    SystemStatusRing<SystemStatusServiceInfo>      mRilServiceInfo;
+    SystemStatusRing<SystemStatusRilCellInfo>      mRilCellInfo;
+    SystemStatusRing<SystemStatusServiceStatus>    mServiceStatus;
+    SystemStatusRing<SystemStatusModel>            mModel;
+    SystemStatusRing<SystemStatusManufacturer>     mManufacturer;
+    SystemStatusRing<SystemStatusAssistedGps>      mAssistedGps;
+    SystemStatusRing<SystemStatusScreenState>      mScreenState;
+    SystemStatusRing<SystemStatusPowerConnectState> mPowerConnectState;
+    SystemStatusRing<SystemStatusTimeZoneChange>   mTimeZoneChange;
+    SystemStatusRing<SystemStatusTimeChange>       mTimeChange;
+    SystemStatusRing<SystemStatusWifiSupplicantStatus> mWifiSupplicantStatus;
+    SystemStatusRing<SystemStatusShutdownState>    mShutdownState;
+    SystemStatusRing<SystemStatusTac>              mTac;
+    SystemStatusRing<SystemStatusMccMnc>           mMccMnc;
+    SystemStatusRing<SystemStatusBtDeviceScanDetail> mBtDeviceScanDetail;
+    SystemStatusRing<SystemStatusBtleDeviceScanDetail> mBtLeDeviceScanDetail;
 };
 
 /******************************************************************************
@@ -894,6 +980,20 @@ private:
     template <typename TYPE_REPORT, typename TYPE_ITEM>
     void getIteminReport(TYPE_REPORT& reportout, const TYPE_ITEM& c) const;
 
+    // handlers of the dataitems and of the debug NMEA sentences, dispatched
+    // from tables keyed by DataItemId and by sentence tag
+    typedef bool (SystemStatus::*DataItemHandler)(IDataItemCore* dataitem);
+    typedef void (SystemStatus::*NmeaHandler)(const char* data, uint32_t len);
+
+    template <typename TYPE_ITEM, typename TYPE_BASE,
+              SystemStatusRing<TYPE_ITEM> SystemStatusReports::*REPORT>
+    bool setDataIteminReport(IDataItemCore* dataitem);
+
+    template <typename TYPE_ITEM, typename TYPE_PARSER,
+              SystemStatusRing<TYPE_ITEM> SystemStatusReports::*REPORT>
+    void setNmeainReport(const char* data, uint32_t len);
+    void setPQWM1inReport(const char* data, uint32_t len);
+
 public:
     // Static methods
     static SystemStatus* getInstance(const MsgTask* msgTask);
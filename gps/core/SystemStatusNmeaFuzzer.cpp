@@ -0,0 +1,64 @@
+/* Copyright (c) 2020 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/* Fuzz target of the SystemStatus debug NMEA parsers. Each line of the input
+   goes through SystemStatus::setNmeaString(), which tokenizes $PQWM1 /
+   $PQWPx / $PQWS1 sentences in place, and the reports are read back. */
+
+#include <SystemStatus.h>
+#include <MsgTask.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+
+using namespace loc_core;
+using namespace loc_util;
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    static MsgTask* msgTask = new MsgTask("SystemStatusFuzz");
+    static SystemStatus* systemStatus = SystemStatus::getInstance(msgTask);
+
+    const char* line = (const char*)data;
+    const char* end = line + size;
+    while (line < end) {
+        const char* eol = (const char*)memchr(line, '\n', end - line);
+        if (nullptr == eol) {
+            eol = end;
+        }
+        // a sentence from the engine is NUL terminated, as in the copy here
+        std::string sentence(line, eol - line);
+        systemStatus->setNmeaString(sentence.c_str(), sentence.size());
+        line = eol + 1;
+    }
+
+    SystemStatusReports reports = {};
+    systemStatus->getReport(reports, true);
+    return 0;
+}
@@ -36,15 +36,6 @@
 
 namespace loc_core
 {
-template <typename CINT, typename COUT>
-COUT SystemStatusOsObserver::containerTransfer(CINT& inContainer) {
-    COUT outContainer = {};
-    for (auto item : inContainer) {
-        outContainer.insert(outContainer.begin(), item);
-    }
-    return outContainer;
-}
-
 SystemStatusOsObserver::~SystemStatusOsObserver() {
     // Close data-item library handle
     DataItemsFactoryProxy::closeDataItemLibraryHandle();
@@ -70,10 +61,9 @@ void SystemStatusOsObserver::setSubscriptionObj(IDataItemSubscription* subscript
             LOC_LOGi("SetSubsObj::enter");
             mContext.mSubscriptionObj = mSubsObj;
 
-            if (!mContext.mSSObserver->mDataItemToClients.empty()) {
-                list<DataItemId> dis(
-                        containerTransfer<unordered_set<DataItemId>, list<DataItemId>>(
-                                mContext.mSSObserver->mDataItemToClients.getKeys()));
+            DataItemIdSet subscribed(mContext.mSSObserver->getSubscribedDataItems());
+            if (subscribed.any()) {
+                list<DataItemId> dis(toDataItemIdList(subscribed));
                 mContext.mSubscriptionObj->subscribe(dis, mContext.mSSObserver);
                 mContext.mSubscriptionObj->requestData(dis, mContext.mSSObserver);
             }
@@ -98,14 +88,13 @@ void SystemStatusOsObserver::subscribe(const list<DataItemId>& l, IDataItemObser
         inline HandleSubscribeReq(SystemStatusOsObserver* parent,
                 list<DataItemId>& l, IDataItemObserver* client, bool requestData) :
                 mParent(parent), mClient(client),
-                mDataItemSet(containerTransfer<list<DataItemId>, unordered_set<DataItemId>>(l)),
+                mDataItemSet(toDataItemIdSet(l)),
                 diItemlist(l),
                 mToRequestData(requestData) {}
 
         void proc() const {
-            unordered_set<DataItemId> dataItemsToSubscribe = {};
-            mParent->mDataItemToClients.add(mDataItemSet, {mClient}, &dataItemsToSubscribe);
-            mParent->mClientToDataItems.add(mClient, mDataItemSet);
+            int slot = mParent->getClientSlot(mClient, true);
+            DataItemIdSet dataItemsToSubscribe = mParent->addClient(mDataItemSet, slot);
 
             mParent->sendCachedDataItems(mDataItemSet, mClient);
 
@@ -114,19 +103,17 @@ void SystemStatusOsObserver::subscribe(const list<DataItemId>& l, IDataItemObser
                 if (mToRequestData) {
                     LOC_LOGD("Request Data sent to framework for the following");
                     mParent->mContext.mSubscriptionObj->requestData(diItemlist, mParent);
-                } else if (!dataItemsToSubscribe.empty()) {
+                } else if (dataItemsToSubscribe.any()) {
                     LOC_LOGD("Subscribe Request sent to framework for the following");
                     mParent->logMe(dataItemsToSubscribe);
                     mParent->mContext.mSubscriptionObj->subscribe(
-                            containerTransfer<unordered_set<DataItemId>, list<DataItemId>>(
-                                    std::move(dataItemsToSubscribe)),
-                            mParent);
+                            toDataItemIdList(dataItemsToSubscribe), mParent);
                 }
             }
         }
         mutable SystemStatusOsObserver* mParent;
         IDataItemObserver* mClient;
-        const unordered_set<DataItemId> mDataItemSet;
+        const DataItemIdSet mDataItemSet;
         const list<DataItemId> diItemlist;
         bool mToRequestData;
     };
@@ -146,61 +133,48 @@ void SystemStatusOsObserver::updateSubscription(
         HandleUpdateSubscriptionReq(SystemStatusOsObserver* parent,
                                     list<DataItemId>& l, IDataItemObserver* client) :
                 mParent(parent), mClient(client),
-                mDataItemSet(containerTransfer<list<DataItemId>, unordered_set<DataItemId>>(l)) {}
+                mDataItemSet(toDataItemIdSet(l)) {}
 
         void proc() const {
-            unordered_set<DataItemId> dataItemsToSubscribe = {};
-            unordered_set<DataItemId> dataItemsToUnsubscribe = {};
-            unordered_set<IDataItemObserver*> clients({mClient});
-            // below removes clients from all entries keyed with the return of the
-            // mClientToDataItems.update() call. If leaving an empty set of clients as the
-            // result, the entire entry will be removed. dataItemsToUnsubscribe will be
-            // populated to keep the keys of the removed entries.
-            mParent->mDataItemToClients.trimOrRemove(
-                    // this call updates <IDataItemObserver*, DataItemId> map; removes
-                    // the DataItemId's that are not new to the clietn from mDataItemSet;
-                    // and returns a set of mDataItemSet's that are no longer used by client.
-                    // This unused set of mDataItemSet's is passed to trimOrRemove method of
-                    // <DataItemId, IDataItemObserver*> map to remove the client from the
-                    // corresponding entries, and gets a set of the entries that are
-                    // removed from the <DataItemId, IDataItemObserver*> map as a result.
-                    mParent->mClientToDataItems.update(mClient,
-                                                       (unordered_set<DataItemId>&)mDataItemSet),
-                    clients, &dataItemsToUnsubscribe, nullptr);
-            // below adds mClient to <DataItemId, IDataItemObserver*> map, and populates
-            // new keys added to that map, which are DataItemIds to be subscribed.
-            mParent->mDataItemToClients.add(mDataItemSet, clients, &dataItemsToSubscribe);
+            int slot = mParent->getClientSlot(mClient, true);
+            // the client keeps the dataitems it has in both the old and the new
+            // set, drops the ones only in the old set and gets the new ones
+            DataItemIdSet curDataItems = mParent->mClientToDataItems[slot];
+            DataItemIdSet newDataItems = mDataItemSet & ~curDataItems;
+            DataItemIdSet dataItemsToUnsubscribe =
+                    mParent->removeClient(curDataItems & ~mDataItemSet, slot);
+            if (newDataItems.any()) {
+                // the slot may just have been freed
+                slot = mParent->getClientSlot(mClient, true);
+            }
+            DataItemIdSet dataItemsToSubscribe = mParent->addClient(newDataItems, slot);
 
             // Send First Response
-            mParent->sendCachedDataItems(mDataItemSet, mClient);
+            mParent->sendCachedDataItems(newDataItems, mClient);
 
             if (nullptr != mParent->mContext.mSubscriptionObj) {
                 // Send subscription set to framework
-                if (!dataItemsToSubscribe.empty()) {
+                if (dataItemsToSubscribe.any()) {
                     LOC_LOGD("Subscribe Request sent to framework for the following");
                     mParent->logMe(dataItemsToSubscribe);
 
                     mParent->mContext.mSubscriptionObj->subscribe(
-                            containerTransfer<unordered_set<DataItemId>, list<DataItemId>>(
-                                    std::move(dataItemsToSubscribe)),
-                            mParent);
+                            toDataItemIdList(dataItemsToSubscribe), mParent);
                 }
 
                 // Send unsubscribe to framework
-                if (!dataItemsToUnsubscribe.empty()) {
+                if (dataItemsToUnsubscribe.any()) {
                     LOC_LOGD("Unsubscribe Request sent to framework for the following");
                     mParent->logMe(dataItemsToUnsubscribe);
 
                     mParent->mContext.mSubscriptionObj->unsubscribe(
-                            containerTransfer<unordered_set<DataItemId>, list<DataItemId>>(
-                                    std::move(dataItemsToUnsubscribe)),
-                            mParent);
+                            toDataItemIdList(dataItemsToUnsubscribe), mParent);
                 }
             }
         }
         SystemStatusOsObserver* mParent;
         IDataItemObserver* mClient;
-        unordered_set<DataItemId> mDataItemSet;
+        DataItemIdSet mDataItemSet;
     };
 
     if (l.empty() || nullptr == client) {
@@ -218,31 +192,28 @@ void SystemStatusOsObserver::unsubscribe(
         HandleUnsubscribeReq(SystemStatusOsObserver* parent,
                 list<DataItemId>& l, IDataItemObserver* client) :
                 mParent(parent), mClient(client),
-                mDataItemSet(containerTransfer<list<DataItemId>, unordered_set<DataItemId>>(l)) {}
+                mDataItemSet(toDataItemIdSet(l)) {}
 
         void proc() const {
-            unordered_set<DataItemId> dataItemsUnusedByClient = {};
-            unordered_set<IDataItemObserver*> clientToRemove = {};
-            unordered_set<DataItemId> dataItemsToUnsubscribe = {};
-            mParent->mClientToDataItems.trimOrRemove({mClient}, mDataItemSet,  &clientToRemove,
-                                                     &dataItemsUnusedByClient);
-            mParent->mDataItemToClients.trimOrRemove(dataItemsUnusedByClient, {mClient},
-                                                     &dataItemsToUnsubscribe, nullptr);
-
-            if (nullptr != mParent->mContext.mSubscriptionObj && !dataItemsToUnsubscribe.empty()) {
+            int slot = mParent->getClientSlot(mClient, false);
+            if (slot < 0) {
+                return;
+            }
+            DataItemIdSet dataItemsToUnsubscribe = mParent->removeClient(
+                    mParent->mClientToDataItems[slot] & mDataItemSet, slot);
+
+            if (nullptr != mParent->mContext.mSubscriptionObj && dataItemsToUnsubscribe.any()) {
                 LOC_LOGD("Unsubscribe Request sent to framework for the following data items");
                 mParent->logMe(dataItemsToUnsubscribe);
 
                 // Send unsubscribe to framework
                 mParent->mContext.mSubscriptionObj->unsubscribe(
-                        containerTransfer<unordered_set<DataItemId>, list<DataItemId>>(
-                                  std::move(dataItemsToUnsubscribe)),
-                        mParent);
+                        toDataItemIdList(dataItemsToUnsubscribe), mParent);
             }
         }
         SystemStatusOsObserver* mParent;
         IDataItemObserver* mClient;
-        unordered_set<DataItemId> mDataItemSet;
+        DataItemIdSet mDataItemSet;
     };
 
     if (l.empty() || nullptr == client) {
@@ -260,15 +231,13 @@ void SystemStatusOsObserver::unsubscribeAll(IDataItemObserver* client)
                 mParent(parent), mClient(client) {}
 
         void proc() const {
-            unordered_set<DataItemId> diByClient = mParent->mClientToDataItems.getValSet(mClient);
+            int slot = mParent->getClientSlot(mClient, false);
 
-            if (!diByClient.empty()) {
-                unordered_set<DataItemId> dataItemsToUnsubscribe;
-                mParent->mClientToDataItems.remove(mClient);
-                mParent->mDataItemToClients.trimOrRemove(diByClient, {mClient},
-                                                         &dataItemsToUnsubscribe, nullptr);
+            if (slot >= 0) {
+                DataItemIdSet dataItemsToUnsubscribe =
+                        mParent->removeClient(mParent->mClientToDataItems[slot], slot);
 
-                if (!dataItemsToUnsubscribe.empty() &&
+                if (dataItemsToUnsubscribe.any() &&
                     nullptr != mParent->mContext.mSubscriptionObj) {
 
                     LOC_LOGD("Unsubscribe Request sent to framework for the following data items");
@@ -276,9 +245,7 @@ void SystemStatusOsObserver::unsubscribeAll(IDataItemObserver* client)
 
                     // Send unsubscribe to framework
                     mParent->mContext.mSubscriptionObj->unsubscribe(
-                            containerTransfer<unordered_set<DataItemId>, list<DataItemId>>(
-                                    std::move(dataItemsToUnsubscribe)),
-                            mParent);
+                            toDataItemIdList(dataItemsToUnsubscribe), mParent);
                 }
             }
         }
@@ -311,35 +278,27 @@ void SystemStatusOsObserver::notify(const list<IDataItemCore*>& dlist)
         void proc() const {
             // Update Cache with received data items and prepare
             // list of data items to be sent.
-            unordered_set<DataItemId> dataItemIdsToBeSent = {};
+            DataItemIdSet dataItemIdsToBeSent;
             for (auto item : mDiVec) {
                 if (mParent->updateCache(item)) {
-                    dataItemIdsToBeSent.insert(item->getId());
+                    dataItemIdsToBeSent.set(item->getId());
                 }
             }
 
             // Send data item to all subscribed clients
-            unordered_set<IDataItemObserver*> clientSet = {};
-            for (auto each : dataItemIdsToBeSent) {
-                auto clients = mParent->mDataItemToClients.getValSetPtr(each);
-                if (nullptr != clients) {
-                    clientSet.insert(clients->begin(), clients->end());
+            ClientSlotSet clientSlots;
+            for (size_t id = 0; id < dataItemIdsToBeSent.size(); id++) {
+                if (dataItemIdsToBeSent.test(id)) {
+                    clientSlots |= mParent->mDataItemToClients[id];
                 }
             }
 
-            for (auto client : clientSet) {
-                unordered_set<DataItemId> dataItemIdsForThisClient(
-                        mParent->mClientToDataItems.getValSet(client));
-                for (auto itr = dataItemIdsForThisClient.begin();
-                        itr != dataItemIdsForThisClient.end(); ) {
-                    if (dataItemIdsToBeSent.find(*itr) == dataItemIdsToBeSent.end()) {
-                        itr = dataItemIdsForThisClient.erase(itr);
-                    } else {
-                        itr++;
-                    }
+            for (size_t slot = 0; slot < clientSlots.size(); slot++) {
+                if (clientSlots.test(slot)) {
+                    mParent->sendCachedDataItems(
+                            mParent->mClientToDataItems[slot] & dataItemIdsToBeSent,
+                            mParent->mClients[slot]);
                 }
-
-                mParent->sendCachedDataItems(dataItemIdsForThisClient, client);
             }
         }
         SystemStatusOsObserver* mParent;
@@ -528,7 +487,7 @@ bool SystemStatusOsObserver::disconnectBackhaul(const string& clientName)
  Helpers
 ******************************************************************************/
 void SystemStatusOsObserver::sendCachedDataItems(
-        const unordered_set<DataItemId>& s, IDataItemObserver* to)
+        const DataItemIdSet& s, IDataItemObserver* to)
 {
     if (nullptr == to) {
         LOC_LOGv("client pointer is NULL.");
@@ -537,8 +496,11 @@ void SystemStatusOsObserver::sendCachedDataItems(
         to->getName(clientName);
         list<IDataItemCore*> dataItems = {};
 
-        for (auto each : s) {
-            auto citer = mDataItemCache.find(each);
+        for (size_t each = 0; each < s.size(); each++) {
+            if (!s.test(each)) {
+                continue;
+            }
+            auto citer = mDataItemCache.find((DataItemId)each);
             if (citer != mDataItemCache.end()) {
                 string dv;
                 citer->second->stringify(dv);
@@ -559,34 +521,126 @@ bool SystemStatusOsObserver::updateCache(IDataItemCore* d)
 {
     bool dataItemUpdated = false;
 
-    // Request systemstatus to record this dataitem in its cache
-    // if the return is false, it means that SystemStatus is not
-    // handling it, so SystemStatusOsObserver also doesn't.
-    // So it has to be true to proceed.
+    // Request systemstatus to record this dataitem in its cache.
+    // It returns true only for a dataitem it handles whose content differs
+    // from the one it has recorded last, as compared by equals() of its
+    // SystemStatus item, so an unchanged dataitem is not sent to the clients.
     if (nullptr != d && mSystemStatus->eventDataItemNotify(d)) {
-        auto citer = mDataItemCache.find(d->getId());
+        DataItemId id = d->getId();
+        auto citer = mDataItemCache.find(id);
+
         if (citer == mDataItemCache.end()) {
             // New data item; not found in cache
-            IDataItemCore* dataitem = DataItemsFactoryProxy::createNewDataItem(d->getId());
+            IDataItemCore* dataitem = DataItemsFactoryProxy::createNewDataItem(id);
             if (nullptr != dataitem) {
                 // Copy the contents of the data item
                 dataitem->copy(d);
                 // Insert in mDataItemCache
-                mDataItemCache.insert(std::make_pair(d->getId(), dataitem));
+                mDataItemCache.insert(std::make_pair(id, dataitem));
                 dataItemUpdated = true;
             }
         } else {
-            // Found in cache; Update cache if necessary
-            citer->second->copy(d, &dataItemUpdated);
+            // Found in cache; update it with the changed content
+            citer->second->copy(d);
+            dataItemUpdated = true;
         }
 
         if (dataItemUpdated) {
-            LOC_LOGV("DataItem:%d updated:%d", d->getId(), dataItemUpdated);
+            LOC_LOGV("DataItem:%d updated:%d", id, dataItemUpdated);
         }
     }
 
     return dataItemUpdated;
 }
 
+int SystemStatusOsObserver::getClientSlot(IDataItemObserver* client, bool toAdd)
+{
+    int freeSlot = -1;
+    for (int slot = 0; slot < (int)mClients.size(); slot++) {
+        if (client == mClients[slot]) {
+            return slot;
+        } else if (nullptr == mClients[slot] && freeSlot < 0) {
+            freeSlot = slot;
+        }
+    }
+    if (!toAdd) {
+        return -1;
+    }
+    if (freeSlot < 0) {
+        freeSlot = mClients.size();
+        mClients.push_back(nullptr);
+        mClientToDataItems.emplace_back();
+    }
+    mClients[freeSlot] = client;
+    return freeSlot;
+}
+
+DataItemIdSet SystemStatusOsObserver::addClient(const DataItemIdSet& s, int slot)
+{
+    DataItemIdSet newDataItems;
+    for (size_t id = 0; id < s.size(); id++) {
+        if (s.test(id)) {
+            if (mDataItemToClients[id].none()) {
+                newDataItems.set(id);
+            }
+            mDataItemToClients[id].set(slot);
+        }
+    }
+    mClientToDataItems[slot] |= s;
+    if (mClientToDataItems[slot].none()) {
+        mClients[slot] = nullptr;
+    }
+    return newDataItems;
+}
+
+DataItemIdSet SystemStatusOsObserver::removeClient(const DataItemIdSet& s, int slot)
+{
+    DataItemIdSet goneDataItems;
+    for (size_t id = 0; id < s.size(); id++) {
+        if (s.test(id) && mDataItemToClients[id].test(slot)) {
+            mDataItemToClients[id].reset(slot);
+            if (mDataItemToClients[id].none()) {
+                goneDataItems.set(id);
+            }
+        }
+    }
+    mClientToDataItems[slot] &= ~s;
+    if (mClientToDataItems[slot].none()) {
+        mClients[slot] = nullptr;
+    }
+    return goneDataItems;
+}
+
+DataItemIdSet SystemStatusOsObserver::getSubscribedDataItems() const
+{
+    DataItemIdSet subscribed;
+    for (auto& dataItems : mClientToDataItems) {
+        subscribed |= dataItems;
+    }
+    return subscribed;
+}
+
+DataItemIdSet SystemStatusOsObserver::toDataItemIdSet(const list<DataItemId>& l)
+{
+    DataItemIdSet s;
+    for (auto id : l) {
+        if (id >= 0 && id < MAX_DATA_ITEM_ID_1_1) {
+            s.set(id);
+        }
+    }
+    return s;
+}
+
+list<DataItemId> SystemStatusOsObserver::toDataItemIdList(const DataItemIdSet& s)
+{
+    list<DataItemId> l;
+    for (size_t id = 0; id < s.size(); id++) {
+        if (s.test(id)) {
+            l.push_back((DataItemId)id);
+        }
+    }
+    return l;
+}
+
 } // namespace loc_core
 
@@ -32,7 +32,10 @@
 #include <cinttypes>
 #include <string>
 #include <list>
+#include <bitset>
 #include <map>
+#include <unordered_map>
+#include <unordered_set>
 #include <new>
 #include <vector>
 
@@ -41,7 +44,6 @@
 #include <IOsObserver.h>
 #include <loc_pla.h>
 #include <log_util.h>
-#include <LocUnorderedSetMap.h>
 
 namespace loc_core
 {
@@ -56,8 +58,46 @@ class IDataItemCore;
 class SystemStatus;
 class SystemStatusOsObserver;
 typedef map<IDataItemObserver*, list<DataItemId>> ObserverReqCache;
-typedef LocUnorderedSetMap<IDataItemObserver*, DataItemId> ClientToDataItems;
-typedef LocUnorderedSetMap<DataItemId, IDataItemObserver*> DataItemToClients;
+// DataItemIds are a small dense enum, so a set of them is a bitmap. Each
+// client takes a slot, and a set of clients is a bitmap of their slots,
+// which grows with the number of slots taken.
+typedef bitset<MAX_DATA_ITEM_ID_1_1> DataItemIdSet;
+class ClientSlotSet {
+    vector<uint64_t> mWords;
+public:
+    inline size_t size() const { return mWords.size() * 64; }
+    inline bool test(size_t slot) const {
+        return slot / 64 < mWords.size() && 0 != (mWords[slot / 64] & (1ULL << (slot % 64)));
+    }
+    inline void set(size_t slot) {
+        if (slot / 64 >= mWords.size()) {
+            mWords.resize(slot / 64 + 1, 0);
+        }
+        mWords[slot / 64] |= 1ULL << (slot % 64);
+    }
+    inline void reset(size_t slot) {
+        if (slot / 64 < mWords.size()) {
+            mWords[slot / 64] &= ~(1ULL << (slot % 64));
+        }
+    }
+    inline bool none() const {
+        for (auto word : mWords) {
+            if (0 != word) {
+                return false;
+            }
+        }
+        return true;
+    }
+    inline ClientSlotSet& operator|=(const ClientSlotSet& other) {
+        if (other.mWords.size() > mWords.size()) {
+            mWords.resize(other.mWords.size(), 0);
+        }
+        for (size_t i = 0; i < other.mWords.size(); i++) {
+            mWords[i] |= other.mWords[i];
+        }
+        return *this;
+    }
+};
 typedef unordered_map<DataItemId, IDataItemCore*> DataItemIdToCore;
 typedef unordered_map<DataItemId, int> DataItemIdToInt;
 #ifdef USE_GLIB
@@ -86,19 +126,11 @@ public:
     // ctor
     inline SystemStatusOsObserver(SystemStatus* systemstatus, const MsgTask* msgTask) :
             mSystemStatus(systemstatus), mContext(msgTask, this),
-            mAddress("SystemStatusOsObserver"),
-            mClientToDataItems(MAX_DATA_ITEM_ID), mDataItemToClients(MAX_DATA_ITEM_ID) {}
+            mAddress("SystemStatusOsObserver") {}
 
     // dtor
     ~SystemStatusOsObserver();
 
-    template <typename CINT, typename COUT>
-    static COUT containerTransfer(CINT& s);
-    template <typename CINT, typename COUT>
-    inline static COUT containerTransfer(CINT&& s) {
-        return containerTransfer<CINT, COUT>(s);
-    }
-
     // To set the subscription object
     virtual void setSubscriptionObj(IDataItemSubscription* subscriptionObj);
 
@@ -148,8 +180,11 @@ private:
     SystemStatus*                                    mSystemStatus;
     ObserverContext                                  mContext;
     const string                                     mAddress;
-    ClientToDataItems                                mClientToDataItems;
-    DataItemToClients                                mDataItemToClients;
+    // the client in each slot, nullptr if the slot is free
+    vector<IDataItemObserver*>                       mClients;
+    // the dataitems of the client in each slot, and the clients of each dataitem
+    vector<DataItemIdSet>                            mClientToDataItems;
+    ClientSlotSet                                    mDataItemToClients[MAX_DATA_ITEM_ID_1_1];
     DataItemIdToCore                                 mDataItemCache;
     DataItemIdToInt                                  mActiveRequestCount;
 
@@ -164,12 +199,27 @@ private:
     void subscribe(const list<DataItemId>& l, IDataItemObserver* client, bool toRequestData);
 
     // Helpers
-    void sendCachedDataItems(const unordered_set<DataItemId>& s, IDataItemObserver* to);
+    void sendCachedDataItems(const DataItemIdSet& s, IDataItemObserver* to);
     bool updateCache(IDataItemCore* d);
-    inline void logMe(const unordered_set<DataItemId>& l) {
+    // slot of the client, which takes a free or a new slot if it has none and
+    // toAdd is set; -1 if it has none and toAdd is not set
+    int getClientSlot(IDataItemObserver* client, bool toAdd);
+    // add the client in slot to the dataitems in s, return the dataitems that
+    // had no client before. The slot is freed if the client is left with none.
+    DataItemIdSet addClient(const DataItemIdSet& s, int slot);
+    // remove the client in slot from the dataitems in s, return the dataitems
+    // that are left without a client. The slot is freed if the client is left
+    // with none.
+    DataItemIdSet removeClient(const DataItemIdSet& s, int slot);
+    DataItemIdSet getSubscribedDataItems() const;
+    static DataItemIdSet toDataItemIdSet(const list<DataItemId>& l);
+    static list<DataItemId> toDataItemIdList(const DataItemIdSet& s);
+    inline void logMe(const DataItemIdSet& s) {
         IF_LOC_LOGD {
-            for (auto id : l) {
-                LOC_LOGD("DataItem %d", id);
+            for (size_t id = 0; id < s.size(); id++) {
+                if (s.test(id)) {
+                    LOC_LOGD("DataItem %d", (int)id);
+                }
             }
         }
     }
@@ -59,6 +59,13 @@
 #define NMEA_MAX_THRESHOLD_MSEC (975)
 
 #define DGNSS_RANGE_UPDATE_TIME_10MIN_IN_MILLI  600000
+#define MSG_TASK_TRACE_FILE "/data/vendor/location/gnss_msgtask.trace"
+
+// kinds of GnssAdapter msgs that coalesce in the MsgTask queue
+enum {
+    GNSS_MSG_COALESCE_SV = 1,
+    GNSS_MSG_COALESCE_DEBUG_NMEA,
+};
 
 using namespace loc_core;
 
@@ -92,6 +99,7 @@ GnssAdapter::GnssAdapter() :
     mSPEAlreadyRunningAtHighestInterval(false),
     mGnssSvIdUsedInPosition(),
     mGnssSvIdUsedInPosAvail(false),
+    mPositionEpoch(0),
     mControlCallbacks(),
     mAfwControlId(0),
     mNmeaMask(0),
@@ -3652,6 +3660,9 @@ GnssAdapter::reportPositionEvent(const UlpLocation& ulpLocation,
             mTechMask(techMask),
             mDataNotify(dataNotify),
             mMsInWeek(msInWeek) {}
+        inline virtual LocMsgLane getLane() const {
+            return LOC_MSG_LANE_POSITION;
+        }
         inline virtual void proc() const {
             if (mAdapter.mTimeBasedTrackingSessions.empty() &&
                 mAdapter.mDistanceBasedTrackingSessions.empty()) {
@@ -3709,6 +3720,7 @@ GnssAdapter::reportPositionEvent(const UlpLocation& ulpLocation,
             dataNotifyCopy = *pDataNotify;
             dataNotifyCopy.size = sizeof(dataNotifyCopy);
         }
+        mPositionEpoch++;
         sendMsg(new MsgReportSPEPosition(*this, ulpLocation, locationExtended,
                                           status, techMask, dataNotifyCopy, msInWeek));
     }
@@ -3735,11 +3747,15 @@ GnssAdapter::reportEnginePositionsEvent(unsigned int count,
                 memcpy(mEngLocInfo, locationArr, sizeof(EngineLocationInfo)*mCount);
             }
         }
+        inline virtual LocMsgLane getLane() const {
+            return LOC_MSG_LANE_POSITION;
+        }
         inline virtual void proc() const {
             mAdapter.reportEnginePositions(mCount, mEngLocInfo);
         }
     };
 
+    mPositionEpoch++;
     sendMsg(new MsgReportEnginePositions(*this, count, locationArr));
 }
 
@@ -3889,21 +3905,17 @@ GnssAdapter::reportPosition(const UlpLocation& ulpLocation,
                           (LOC_RELIABILITY_NOT_SET == locationExtended.horizontal_reliability));
         uint8_t generate_nmea = (reportToGnssClient && status != LOC_SESS_FAILURE && !blank_fix);
         bool custom_nmea_gga = (1 == ContextBase::mGps_conf.CUSTOM_NMEA_GGA_FIX_QUALITY_ENABLED);
-        std::vector<std::string> nmeaArraystr;
-        int indexOfGGA = -1;
+        LocNmeaEpoch nmea;
+        loc_nmea_epoch_init(nmea, mNmeaEpochBuf, sizeof(mNmeaEpochBuf));
         loc_nmea_generate_pos(ulpLocation, locationExtended, mLocSystemInfo,
-                              generate_nmea, custom_nmea_gga, nmeaArraystr, indexOfGGA);
-        stringstream ss;
-        for (auto itor = nmeaArraystr.begin(); itor != nmeaArraystr.end(); ++itor) {
-            ss << *itor;
-        }
-        string s = ss.str();
-        reportNmea(s.c_str(), s.length());
+                              generate_nmea, custom_nmea_gga, nmea);
+        reportNmea(nmea.buf, nmea.length);
 
         /* DgnssNtrip */
-        if (-1 != indexOfGGA && isDgnssNmeaRequired()) {
+        if (-1 != nmea.indexOfGGA && isDgnssNmeaRequired()) {
             mDgnssState |= DGNSS_STATE_NO_NMEA_PENDING;
-            mStartDgnssNtripParams.nmea = std::move(nmeaArraystr[indexOfGGA]);
+            mStartDgnssNtripParams.nmea.assign(nmea.buf + nmea.offsets[nmea.indexOfGGA],
+                    loc_nmea_epoch_sentence_length(nmea, nmea.indexOfGGA));
             bool isLocationValid = (0 != ulpLocation.gpsLocation.latitude) ||
                     (0 != ulpLocation.gpsLocation.longitude);
             checkUpdateDgnssNtrip(isLocationValid);
@@ -3966,11 +3978,23 @@ GnssAdapter::reportSvEvent(const GnssSvNotification& svNotify,
     struct MsgReportSv : public LocMsg {
         GnssAdapter& mAdapter;
         const GnssSvNotification mSvNotify;
+        const uint32_t mPositionEpoch;
         inline MsgReportSv(GnssAdapter& adapter,
                            const GnssSvNotification& svNotify) :
             LocMsg(),
             mAdapter(adapter),
-            mSvNotify(svNotify) {}
+            mSvNotify(svNotify),
+            mPositionEpoch(adapter.mPositionEpoch) {}
+        // in the lane of the positions, as reportSv() takes the SVs used in
+        // the position reported before it
+        inline virtual LocMsgLane getLane() const {
+            return LOC_MSG_LANE_POSITION;
+        }
+        // a newer SV status replaces one not yet reported of the same epoch,
+        // so no position report is passed over
+        inline virtual uint64_t getCoalesceKey() const {
+            return LocMsg::makeCoalesceKey(GNSS_MSG_COALESCE_SV, mPositionEpoch);
+        }
         inline virtual void proc() const {
             mAdapter.reportSv((GnssSvNotification&)mSvNotify);
         }
@@ -4126,14 +4150,10 @@ GnssAdapter::reportSv(GnssSvNotification& svNotify)
 
     if (NMEA_PROVIDER_AP == ContextBase::mGps_conf.NMEA_PROVIDER &&
         !mTimeBasedTrackingSessions.empty()) {
-        std::vector<std::string> nmeaArraystr;
-        loc_nmea_generate_sv(svNotify, nmeaArraystr);
-        stringstream ss;
-        for (auto itor = nmeaArraystr.begin(); itor != nmeaArraystr.end(); ++itor) {
-            ss << *itor;
-        }
-        string s = ss.str();
-        reportNmea(s.c_str(), s.length());
+        LocNmeaEpoch nmea;
+        loc_nmea_epoch_init(nmea, mNmeaEpochBuf, sizeof(mNmeaEpochBuf));
+        loc_nmea_generate_sv(svNotify, nmea);
+        reportNmea(nmea.buf, nmea.length);
     }
 
     mGnssSvIdUsedInPosAvail = false;
@@ -4152,23 +4172,38 @@ GnssAdapter::reportNmeaEvent(const char* nmea, size_t length)
         GnssAdapter& mAdapter;
         const char* mNmea;
         size_t mLength;
+        uint64_t mCoalesceKey;
         inline MsgReportNmea(GnssAdapter& adapter,
                              const char* nmea,
                              size_t length) :
             LocMsg(),
             mAdapter(adapter),
             mNmea(new char[length+1]),
-            mLength(length) {
+            mLength(length),
+            mCoalesceKey(0) {
                 if (mNmea == nullptr) {
                     LOC_LOGE("%s] new allocation failed, fatal error.", __func__);
                     return;
                 }
                 strlcpy((char*)mNmea, nmea, length+1);
+                // a debug sentence is a full status snapshot, so a newer one
+                // of the same type ($PQWM1, $PQWP1...) replaces a queued one
+                if (loc_nmea_is_debug(nmea, length)) {
+                    mCoalesceKey = LocMsg::makeCoalesceKey(GNSS_MSG_COALESCE_DEBUG_NMEA,
+                                                           loc_nmea_debug_tag(nmea));
+                }
             }
         inline virtual ~MsgReportNmea()
         {
             delete[] mNmea;
         }
+        // GGA/RMC and GSV/GSA stay in order with the positions and SVs
+        inline virtual LocMsgLane getLane() const {
+            return LOC_MSG_LANE_POSITION;
+        }
+        inline virtual uint64_t getCoalesceKey() const {
+            return mCoalesceKey;
+        }
         inline virtual void proc() const {
             // extract bug report info - this returns true if consumed by systemstatus
             bool ret = false;
@@ -4228,6 +4263,9 @@ GnssAdapter::reportDataEvent(const GnssDataNotification& dataNotify,
             mDataNotify(dataNotify),
             mMsInWeek(msInWeek) {
         }
+        inline virtual LocMsgLane getLane() const {
+            return LOC_MSG_LANE_POSITION;
+        }
         inline virtual void proc() const {
             if (mMsInWeek >= 0) {
                 mAdapter.getDataInformation((GnssDataNotification&)mDataNotify,
@@ -4560,6 +4598,9 @@ GnssAdapter::reportGnssMeasurementsEvent(const GnssMeasurements& gnssMeasurement
                     mAdapter.getAgcInformation(mMeasurementsNotify, msInWeek);
                 }
             }
+            inline virtual LocMsgLane getLane() const {
+                return LOC_MSG_LANE_BULK;
+            }
             inline virtual void proc() const {
                 mAdapter.reportGnssMeasurementData(mMeasurementsNotify);
             }
@@ -5281,6 +5322,22 @@ bool GnssAdapter::getDebugReport(GnssDebugReport& r)
     SystemStatusReports reports = {};
     systemstatus->getReport(reports, true);
 
+    static const char* laneNames[LOC_MSG_LANE_MAX] = {"control", "position", "bulk"};
+    for (int lane = 0; lane < LOC_MSG_LANE_MAX; lane++) {
+        LocMsgLaneStats stats;
+        mMsgTask->getLaneStats((LocMsgLane)lane, stats);
+        LOC_LOGd("msg lane %s: depth=%u max=%u processed=%" PRIu64 " coalesced=%" PRIu64,
+                 laneNames[lane], stats.mDepth, stats.mMaxDepth,
+                 stats.mProcessed, stats.mCoalesced);
+    }
+    uint64_t gsvHits = 0, gsvMisses = 0;
+    loc_nmea_get_gsv_cache_stats(gsvHits, gsvMisses);
+    LOC_LOGd("nmea gsv pages: reused=%" PRIu64 " rendered=%" PRIu64, gsvHits, gsvMisses);
+    if (loc_logger.MSG_TASK_PROFILING_ENABLE) {
+        mMsgTask->dumpProfile("adapter");
+        mMsgTask->writeProfileTrace(MSG_TASK_TRACE_FILE);
+    }
+
     r.size = sizeof(r);
 
     // location block
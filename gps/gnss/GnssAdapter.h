@@ -37,7 +37,9 @@
 #include <Agps.h>
 #include <SystemStatus.h>
 #include <XtraSystemStatusObserver.h>
+#include <loc_nmea.h>
 #include <map>
+#include <atomic>
 #include <functional>
 
 #define MAX_URL_LEN 256
@@ -190,6 +192,8 @@ class GnssAdapter : public LocAdapterBase {
     LocPosMode mLocPositionMode;
     GnssSvUsedInPosition mGnssSvIdUsedInPosition;
     bool mGnssSvIdUsedInPosAvail;
+    // counts the position reports sent, the SV reports that follow one are of its epoch
+    std::atomic<uint32_t> mPositionEpoch;
     GnssSvMbUsedInPosition mGnssMbSvIdUsedInPosition;
     bool mGnssMbSvIdUsedInPosAvail;
 
@@ -198,6 +202,7 @@ class GnssAdapter : public LocAdapterBase {
     uint32_t mAfwControlId;
     uint32_t mNmeaMask;
     uint64_t mPrevNmeaRptTimeNsec;
+    char mNmeaEpochBuf[NMEA_EPOCH_MAX_LENGTH]; // NMEA sentences of one report
     GnssSvIdConfig mGnssSvIdConfig;
     GnssSvTypeConfig mGnssSeconaryBandConfig;
     GnssSvTypeConfig mGnssSvTypeConfig;
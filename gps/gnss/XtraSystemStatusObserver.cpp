@@ -115,7 +115,9 @@ XtraSystemStatusObserver::XtraSystemStatusObserver(IOsObserver* sysStatObs,
     auto recver = LocIpc::getLocIpcLocalRecver(
             make_shared<XtraIpcListener>(sysStatObs, msgTask, *this),
             LOC_IPC_HAL);
-    mIpc.startNonBlockingListening(recver);
+    // the listener only parses and posts msgs, so it can share the event
+    // loop thread instead of holding a thread of its own
+    mIpc.startNonBlockingListening(recver, LocEventLoop::getDefault());
     mDelayLocTimer.start(100 /*.1 sec*/,  false);
 }
 
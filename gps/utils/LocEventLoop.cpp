@@ -0,0 +1,208 @@
+/* Copyright (c) 2020 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <unordered_map>
+#include <log_util.h>
+#include <LocEventLoop.h>
+
+#ifdef LOG_TAG
+#undef LOG_TAG
+#endif
+#define LOG_TAG "LocSvc_LocEventLoop"
+
+using std::mutex;
+using std::unique_lock;
+using std::condition_variable;
+using std::unordered_map;
+
+namespace loc_util {
+
+// Owns the epoll fd and the handler table. It is shared between the
+// LocEventLoop and the (detached) loop thread, so that it outlives both.
+class LocEventLoopRunnable : public LocRunnable {
+    static const int MAX_EVENTS = 16;
+    const int mEpollFd;
+    // written to on stop, to wake up epoll_wait()
+    const int mWakeFd;
+    std::atomic<bool> mRunning;
+    std::atomic<std::thread::id> mThreadId;
+    mutex mMutex;
+    condition_variable mCond;
+    unordered_map<int, LocEventHandler*> mHandlers;
+    // handler being called in the loop thread, if any
+    LocEventHandler* mDispatching;
+public:
+    LocEventLoopRunnable();
+    virtual ~LocEventLoopRunnable();
+    bool addFd(int fd, uint32_t events, LocEventHandler& handler);
+    void removeFd(int fd);
+    inline bool isInLoopThread() const {
+        return std::this_thread::get_id() == mThreadId.load();
+    }
+    inline bool isValid() const { return mEpollFd >= 0 && mWakeFd >= 0; }
+    inline virtual void prerun() override { mThreadId = std::this_thread::get_id(); }
+    virtual bool run() override;
+    virtual void interrupt() override;
+};
+
+LocEventLoopRunnable::LocEventLoopRunnable() :
+        mEpollFd(epoll_create1(EPOLL_CLOEXEC)),
+        mWakeFd(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)),
+        mRunning(true), mDispatching(nullptr) {
+    if (isValid()) {
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.fd = mWakeFd;
+        epoll_ctl(mEpollFd, EPOLL_CTL_ADD, mWakeFd, &ev);
+    } else {
+        LOC_LOGe("epoll / eventfd create failure - %s", strerror(errno));
+    }
+}
+
+LocEventLoopRunnable::~LocEventLoopRunnable() {
+    if (mEpollFd >= 0) {
+        close(mEpollFd);
+    }
+    if (mWakeFd >= 0) {
+        close(mWakeFd);
+    }
+}
+
+bool LocEventLoopRunnable::addFd(int fd, uint32_t events, LocEventHandler& handler) {
+    if (fd < 0 || fd == mWakeFd || !isValid()) {
+        return false;
+    }
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = events;
+    ev.data.fd = fd;
+
+    unique_lock<mutex> lock(mMutex);
+    bool existing = (mHandlers.find(fd) != mHandlers.end());
+    if (0 != epoll_ctl(mEpollFd, existing ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, fd, &ev)) {
+        LOC_LOGe("epoll_ctl on fd %d failure - %s", fd, strerror(errno));
+        return false;
+    }
+    mHandlers[fd] = &handler;
+    return true;
+}
+
+void LocEventLoopRunnable::removeFd(int fd) {
+    unique_lock<mutex> lock(mMutex);
+    auto it = mHandlers.find(fd);
+    if (it != mHandlers.end()) {
+        LocEventHandler* handler = it->second;
+        mHandlers.erase(it);
+        epoll_ctl(mEpollFd, EPOLL_CTL_DEL, fd, NULL);
+        if (!isInLoopThread()) {
+            mCond.wait(lock, [this, handler] { return mDispatching != handler; });
+        }
+    }
+}
+
+bool LocEventLoopRunnable::run() {
+    struct epoll_event ev[MAX_EVENTS];
+    int fds = epoll_wait(mEpollFd, ev, MAX_EVENTS, -1);
+
+    if (fds < 0 && errno != EINTR) {
+        LOC_LOGe("epoll_wait failure - %s", strerror(errno));
+        return false;
+    }
+
+    for (int i = 0; i < fds && mRunning; i++) {
+        int fd = ev[i].data.fd;
+        if (fd == mWakeFd) {
+            uint64_t count;
+            (void)read(mWakeFd, &count, sizeof(count));
+            continue;
+        }
+        // the handler may have been removed by an earlier one of this batch
+        unique_lock<mutex> lock(mMutex);
+        auto it = mHandlers.find(fd);
+        if (it == mHandlers.end()) {
+            continue;
+        }
+        mDispatching = it->second;
+        lock.unlock();
+
+        mDispatching->onEvent(fd, ev[i].events);
+
+        lock.lock();
+        mDispatching = nullptr;
+        mCond.notify_all();
+    }
+
+    return mRunning;
+}
+
+void LocEventLoopRunnable::interrupt() {
+    mRunning = false;
+    uint64_t one = 1;
+    (void)write(mWakeFd, &one, sizeof(one));
+}
+
+LocEventLoop::LocEventLoop(const char* threadName) :
+        mThread(), mRunnable(std::make_shared<LocEventLoopRunnable>()) {
+    if (mRunnable->isValid()) {
+        mThread.start(threadName ? threadName : "LocEventLoop", mRunnable);
+    }
+}
+
+LocEventLoop::~LocEventLoop() {
+    mThread.stop();
+}
+
+LocEventLoop& LocEventLoop::getDefault() {
+    static LocEventLoop* sLoop = new LocEventLoop("LocEventLoop");
+    return *sLoop;
+}
+
+bool LocEventLoop::addFd(int fd, uint32_t events, LocEventHandler& handler) {
+    return mRunnable->addFd(fd, events, handler);
+}
+
+void LocEventLoop::removeFd(int fd) {
+    mRunnable->removeFd(fd);
+}
+
+bool LocEventLoop::isInLoopThread() const {
+    return mRunnable->isInLoopThread();
+}
+
+} // namespace loc_util
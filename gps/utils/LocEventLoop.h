@@ -0,0 +1,85 @@
+/* Copyright (c) 2020 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef __LOC_EVENT_LOOP__
+#define __LOC_EVENT_LOOP__
+
+#include <stdint.h>
+#include <memory>
+#include <LocThread.h>
+
+using std::shared_ptr;
+
+namespace loc_util {
+
+// abstract class to be implemented by client to be notified of the events
+// on the fds it adds into a LocEventLoop
+class LocEventHandler {
+public:
+    inline virtual ~LocEventHandler() = default;
+    // called in the loop thread, when fd has any of the events (EPOLLIN etc.)
+    // it is added with, or EPOLLERR / EPOLLHUP.
+    virtual void onEvent(int fd, uint32_t events) = 0;
+};
+
+class LocEventLoopRunnable;
+
+// A single thread that epolls any number of fds, e.g. timerfds, sockets and
+// eventfds, and dispatches their events to the handlers. Clients that only
+// need to react to fd readiness can share one loop instead of each holding
+// a thread of its own blocking on a single fd.
+// Handlers must not block, same as MsgTask msgs.
+class LocEventLoop {
+    LocThread mThread;
+    shared_ptr<LocEventLoopRunnable> mRunnable;
+public:
+    LocEventLoop(const char* threadName = NULL);
+    ~LocEventLoop();
+
+    // The loop shared by the process. It is created on demand, and is never
+    // destroyed, same as the other static resources of LocTimer.
+    static LocEventLoop& getDefault();
+
+    // events:  EPOLLIN / EPOLLOUT etc. the handler is to be notified of.
+    // handler: obj managed by client, must stay valid until removeFd()
+    //          of the same fd returns.
+    // Adding an fd already in the loop updates its events and handler.
+    // return:  true on success; false on failure.
+    bool addFd(int fd, uint32_t events, LocEventHandler& handler);
+
+    // Upon return, handler of fd is not called any more; if removed from a
+    // thread other than the loop, this waits for an ongoing call to return.
+    void removeFd(int fd);
+
+    bool isInLoopThread() const;
+};
+
+} // namespace loc_util
+
+#endif //__LOC_EVENT_LOOP__
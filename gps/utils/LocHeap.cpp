@@ -268,9 +268,102 @@ LocRankable* LocHeap::remove(LocRankable& rankable) {
     return locNode;
 }
 
+LocIndexedHeap::~LocIndexedHeap() {
+    for (auto node : mNodes) {
+        node->mHeapIndex = SIZE_MAX;
+    }
+}
+
+// moves the node at index up while it outranks its parent
+void LocIndexedHeap::siftUp(size_t index) {
+    LocRankable* node = mNodes[index];
+    while (index > 0) {
+        size_t parent = (index - 1) / ARITY;
+        if (!node->outRanks(*mNodes[parent])) {
+            break;
+        }
+        place(mNodes[parent], index);
+        index = parent;
+    }
+    place(node, index);
+}
+
+// moves the node at index down while any of its children outranks it
+void LocIndexedHeap::siftDown(size_t index) {
+    LocRankable* node = mNodes[index];
+    size_t size = mNodes.size();
+    for (;;) {
+        size_t first = index * ARITY + 1;
+        if (first >= size) {
+            break;
+        }
+        size_t last = (first + ARITY < size) ? first + ARITY : size;
+        size_t top = first;
+        for (size_t child = first + 1; child < last; child++) {
+            if (mNodes[child]->outRanks(*mNodes[top])) {
+                top = child;
+            }
+        }
+        if (!mNodes[top]->outRanks(*node)) {
+            break;
+        }
+        place(mNodes[top], index);
+        index = top;
+    }
+    place(node, index);
+}
+
+LocRankable* LocIndexedHeap::removeAt(size_t index) {
+    LocRankable* node = mNodes[index];
+    LocRankable* last = mNodes.back();
+    mNodes.pop_back();
+    if (index < mNodes.size()) {
+        // refill the hole with the last node, which may need to go
+        // either way from there
+        place(last, index);
+        if (index > 0 && last->outRanks(*mNodes[(index - 1) / ARITY])) {
+            siftUp(index);
+        } else {
+            siftDown(index);
+        }
+    }
+    node->mHeapIndex = SIZE_MAX;
+    return node;
+}
+
+void LocIndexedHeap::push(LocRankable& node) {
+    mNodes.push_back(&node);
+    siftUp(mNodes.size() - 1);
+}
+
+LocRankable* LocIndexedHeap::pop() {
+    return mNodes.empty() ? NULL : removeAt(0);
+}
+
+LocRankable* LocIndexedHeap::remove(LocRankable& rankable) {
+    size_t index = rankable.mHeapIndex;
+    if (index < mNodes.size() && mNodes[index] == &rankable) {
+        return removeAt(index);
+    }
+    return NULL;
+}
+
 } // namespace loc_util
 
 #ifdef __LOC_UNIT_TEST__
+bool LocIndexedHeap::checkTree() {
+    for (size_t i = 0; i < mNodes.size(); i++) {
+        if (mNodes[i]->mHeapIndex != i ||
+            (i > 0 && mNodes[i]->outRanks(*mNodes[(i - 1) / ARITY]))) {
+            return false;
+        }
+    }
+    return true;
+}
+uint32_t LocIndexedHeap::getTreeSize() {
+    return mNodes.size();
+}
+
 bool LocHeap::checkTree() {
     return ((NULL == mTree) || mTree->checkNodes());
 }
@@ -30,13 +30,19 @@
 #define __LOC_HEAP__
 
 #include <stddef.h>
+#include <stdint.h>
 #include <string.h>
+#include <vector>
 
 namespace loc_util {
 
 // abstract class to be implemented by client to provide a rankable class
 class LocRankable {
+    friend class LocIndexedHeap;
+    // slot of this obj in the LocIndexedHeap holding it, SIZE_MAX if none
+    size_t mHeapIndex;
 public:
+    inline LocRankable() : mHeapIndex(SIZE_MAX) {}
     virtual inline ~LocRankable() {}
 
     // method to rank objects of such type for sorting purposes.
@@ -95,6 +101,50 @@ public:
 #endif
 };
 
+// An array backed 4-ary heap with the same interface as LocHeap. Nodes live
+// in one contiguous vector, so push / pop don't allocate once the vector has
+// grown to the peak size, and a 4-ary layout keeps the tree shallow and
+// sift-down cache friendly. Each LocRankable remembers its own slot, which
+// makes remove() O(log n) rather than a search of the tree.
+// A LocRankable can only be in one LocIndexedHeap at a time.
+class LocIndexedHeap {
+    static const size_t ARITY = 4;
+    std::vector<LocRankable*> mNodes;
+
+    inline void place(LocRankable* node, size_t index) {
+        mNodes[index] = node;
+        node->mHeapIndex = index;
+    }
+    void siftUp(size_t index);
+    void siftDown(size_t index);
+    LocRankable* removeAt(size_t index);
+public:
+    inline LocIndexedHeap() {}
+    ~LocIndexedHeap();
+
+    // node is reference to an obj that is managed by client, that client
+    //      creates and destroyes. The destroy should happen after the
+    //      node is popped out from the heap.
+    void push(LocRankable& node);
+
+    // Returns NULL if the heap is empty, otherwise the highest ranking node
+    inline LocRankable* peek() { return mNodes.empty() ? NULL : mNodes[0]; }
+
+    // Return - pointer to the node popped out, or NULL if heap is already empty
+    LocRankable* pop();
+
+    // removes the very obj rankable from the heap.
+    // returns the pointer to the node removed; or NULL if it is not in the heap.
+    LocRankable* remove(LocRankable& rankable);
+
+    inline size_t size() const { return mNodes.size(); }
+
+#ifdef __LOC_UNIT_TEST__
+    bool checkTree();
+    uint32_t getTreeSize();
+#endif
+};
+
 } // namespace loc_util
 
 #endif //__LOC_HEAP__
@@ -29,6 +29,15 @@
 
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/epoll.h>
+#include <sys/uio.h>
+#include <sys/mman.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <linux/memfd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <atomic>
 #include <errno.h>
 #include <netinet/in.h>
 #include <netdb.h>
@@ -46,6 +55,13 @@ namespace loc_util {
 #endif
 #define LOG_TAG "LocSvc_LocIpc"
 
+// ring positions are free running and wrap around by design
+#ifdef __clang__
+#define LOC_IPC_WRAPS __attribute__((no_sanitize("unsigned-integer-overflow")))
+#else
+#define LOC_IPC_WRAPS
+#endif
+
 #define SOCK_OP_AND_LOG(buf, length, opable, rtv, exe)  \
     if (nullptr == (buf) || 0 == (length)) { \
         LOC_LOGe("Invalid inputs: buf - %p, length - %u", (buf), (length)); \
@@ -60,6 +76,7 @@ namespace loc_util {
 
 const char Sock::MSG_ABORT[] = "LocIpc::Sock::ABORT";
 const char Sock::LOC_IPC_HEAD[] = "$MSGLEN$";
+const char Sock::LOC_IPC_BIN_HEAD[] = "$LOCBIN";
 ssize_t Sock::send(const void *buf, uint32_t len, int flags, const struct sockaddr *destAddr,
                           socklen_t addrlen) const {
     ssize_t rtv = -1;
@@ -72,8 +89,20 @@ ssize_t Sock::recv(const LocIpcRecver& recver, const shared_ptr<ILocIpcListener>
     if (-1 == sid) {
         sid = mSid;
     } // else it sid would be connection based socket id for recv
-    SOCK_OP_AND_LOG(dataCb.get(), mMaxTxSize, isValid(), rtv,
-                    recvfrom(recver, dataCb, sid, flags, srcAddr, addrlen));
+    if (mNonBlockingRecv) {
+        flags |= MSG_DONTWAIT;
+    }
+    if (mLongMsgLen > 0) {
+        // the rest of a long message comes before anything else
+        SOCK_OP_AND_LOG(dataCb.get(), mMaxTxSize, isValid(), rtv,
+                        recvLongMsgRest(recver, dataCb, sid, flags, srcAddr, addrlen));
+    } else if (mRecvBatch != nullptr && !mBinaryFraming) {
+        SOCK_OP_AND_LOG(dataCb.get(), mMaxTxSize, isValid(), rtv,
+                        recvBatch(recver, dataCb, sid, flags, srcAddr, addrlen));
+    } else {
+        SOCK_OP_AND_LOG(dataCb.get(), mMaxTxSize, isValid(), rtv,
+                        recvfrom(recver, dataCb, sid, flags, srcAddr, addrlen));
+    }
     return rtv;
 }
 ssize_t Sock::sendto(const void *buf, size_t len, int flags, const struct sockaddr *destAddr,
@@ -81,6 +110,10 @@ ssize_t Sock::sendto(const void *buf, size_t len, int flags, const struct sockad
     ssize_t rtv = -1;
     if (len <= mMaxTxSize) {
         rtv = ::sendto(mSid, buf, len, flags, destAddr, addrlen);
+    } else if (mBinaryFraming && len <= MAX_FRAME_SIZE &&
+               ((rtv = sendFramed(buf, len, flags, destAddr, addrlen)) > 0 ||
+                errno != EMSGSIZE)) {
+        // sent as one frame, or failed for reasons other than its size
     } else {
         std::string head(LOC_IPC_HEAD + to_string(len));
         rtv = ::sendto(mSid, head.c_str(), head.length(), flags, destAddr, addrlen);
@@ -94,36 +127,269 @@ ssize_t Sock::sendto(const void *buf, size_t len, int flags, const struct sockad
     }
     return rtv;
 }
+// header and payload go out in one datagram, gathered by the kernel directly
+// from the caller's buffer.
+ssize_t Sock::sendFramed(const void *buf, size_t len, int flags,
+                         const struct sockaddr *destAddr, socklen_t addrlen) const {
+    FrameHead head;
+    memcpy(head.mMagic, LOC_IPC_BIN_HEAD, sizeof(head.mMagic));
+    head.mLength = len;
+    head.mReserved = 0;
+    struct iovec iov[2] = {{&head, sizeof(head)}, {(void*)buf, len}};
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_name = (void*)destAddr;
+    msg.msg_namelen = addrlen;
+    msg.msg_iov = iov;
+    msg.msg_iovlen = 2;
+
+    ssize_t rtv = ::sendmsg(mSid, &msg, flags);
+    if (-1 == rtv && EMSGSIZE == errno) {
+        // a datagram can not be larger than the send buffer, grow it once
+        int size = sizeof(head) + len + 1024;
+        if (0 == setsockopt(mSid, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size))) {
+            rtv = ::sendmsg(mSid, &msg, flags);
+        }
+    }
+    return rtv;
+}
+void Sock::enableBinaryFraming() {
+    int size = MAX_FRAME_SIZE + sizeof(FrameHead);
+    setsockopt(mSid, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+    mBinaryFraming = true;
+}
+// A datagram can not be larger than SO_RCVBUF, so a buffer this big takes
+// any frame in one recvmsg(), without a MSG_PEEK for its size first.
+size_t Sock::recvBufSize() const {
+    size_t size = mMaxTxSize;
+    if (mBinaryFraming) {
+        int rcvBuf = 0;
+        socklen_t optLen = sizeof(rcvBuf);
+        if (0 == getsockopt(mSid, SOL_SOCKET, SO_RCVBUF, &rcvBuf, &optLen) &&
+            (size_t)rcvBuf > size) {
+            size = min((size_t)rcvBuf, (size_t)MAX_FRAME_SIZE + sizeof(FrameHead));
+        }
+    }
+    // one more for a '\0' past the payload
+    return size + 1;
+}
 ssize_t Sock::recvfrom(const LocIpcRecver& recver, const shared_ptr<ILocIpcListener>& dataCb,
                        int sid, int flags, struct sockaddr *srcAddr, socklen_t *addrlen) const  {
-    std::string msg(mMaxTxSize, 0);
-    ssize_t nBytes = ::recvfrom(sid, (void*)msg.data(), msg.size(), flags, srcAddr, addrlen);
-    if (nBytes > 0) {
-        if (strncmp(msg.data(), MSG_ABORT, sizeof(MSG_ABORT)) == 0) {
-            LOC_LOGi("recvd abort msg.data %s", msg.data());
+    if (mRecvBuf.empty()) {
+        mRecvBuf.resize(recvBufSize());
+    }
+    struct iovec iov = {mRecvBuf.data(), mRecvBuf.size() - 1};
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_name = srcAddr;
+    msg.msg_namelen = (nullptr == addrlen) ? 0 : *addrlen;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    ssize_t nBytes = ::recvmsg(sid, &msg, flags);
+    if (nullptr != addrlen) {
+        *addrlen = msg.msg_namelen;
+    }
+    if (-1 == nBytes && (flags & MSG_DONTWAIT) && (EAGAIN == errno || EWOULDBLOCK == errno)) {
+        // nothing pending after all, keep on listening
+        nBytes = 1;
+    } else if (nBytes > 0) {
+        char* data = mRecvBuf.data();
+        // listeners may treat data as a string, same as when it was one
+        data[nBytes] = 0;
+        if (msg.msg_flags & MSG_TRUNC) {
+            // dropped, but still keep on listening
+            LOC_LOGe("msg truncated to %zd bytes, enable binary framing on recver?", nBytes);
+        } else if (strncmp(data, MSG_ABORT, sizeof(MSG_ABORT)) == 0) {
+            LOC_LOGi("recvd abort msg.data %s", data);
             nBytes = 0;
-        } else if (strncmp(msg.data(), LOC_IPC_HEAD, sizeof(LOC_IPC_HEAD) - 1)) {
+        } else if ((size_t)nBytes >= sizeof(FrameHead) &&
+                   0 == memcmp(data, LOC_IPC_BIN_HEAD, sizeof(LOC_IPC_BIN_HEAD))) {
+            // binary framed message
+            FrameHead head;
+            memcpy(&head, data, sizeof(head));
+            if (head.mLength == nBytes - sizeof(head)) {
+                dataCb->onReceive(data + sizeof(head), head.mLength, &recver);
+            } else {
+                LOC_LOGe("bad frame length %u in %zd bytes", head.mLength, nBytes);
+            }
+        } else if (strncmp(data, LOC_IPC_HEAD, sizeof(LOC_IPC_HEAD) - 1)) {
             // short message
-            msg.resize(nBytes);
-            dataCb->onReceive(msg.data(), nBytes, &recver);
+            dataCb->onReceive(data, nBytes, &recver);
         } else {
             // long message
+            nBytes = recvLongMsg(recver, dataCb, data, nullptr, 0, sid, flags, srcAddr, addrlen);
+        }
+    }
+
+    return nBytes;
+}
+// Assembles a message sent in fragments after a LOC_IPC_HEAD head, from the
+// fragments already received (in batch mode), then from the socket.
+ssize_t Sock::recvLongMsg(const LocIpcRecver& recver, const shared_ptr<ILocIpcListener>& dataCb,
+                          const char* head, const LocIpcMsg* frags, uint32_t fragCount,
+                          int sid, int flags, struct sockaddr *srcAddr,
+                          socklen_t *addrlen) const {
+    size_t msgLen = 0;
+    sscanf(head + sizeof(LOC_IPC_HEAD) - 1, "%zu", &msgLen);
+    // head may point into mRecvBuf, done with it from here
+    if (mRecvBuf.size() < msgLen + 1) {
+        mRecvBuf.resize(msgLen + 1);
+    }
+    char* data = mRecvBuf.data();
+    size_t msgLenReceived = 0;
+    for (uint32_t i = 0; i < fragCount && msgLenReceived < msgLen; i++) {
+        size_t len = min((size_t)frags[i].len, msgLen - msgLenReceived);
+        memcpy(data + msgLenReceived, frags[i].data, len);
+        msgLenReceived += len;
+    }
+    mLongMsgLen = msgLen;
+    mLongMsgReceived = msgLenReceived;
+    return recvLongMsgRest(recver, dataCb, sid, flags, srcAddr, addrlen);
+}
+// Receives the fragments of the long message being assembled. When the
+// receives do not block and the rest is yet to come, the message stays
+// pending and the next receive carries on with it.
+ssize_t Sock::recvLongMsgRest(const LocIpcRecver& recver,
+                              const shared_ptr<ILocIpcListener>& dataCb,
+                              int sid, int flags, struct sockaddr *srcAddr,
+                              socklen_t *addrlen) const {
+    char* data = mRecvBuf.data();
+    ssize_t nBytes = 1;
+    while (mLongMsgReceived < mLongMsgLen && nBytes > 0) {
+        nBytes = ::recvfrom(sid, data + mLongMsgReceived, mLongMsgLen - mLongMsgReceived,
+                            flags, srcAddr, addrlen);
+        if (nBytes > 0) {
+            mLongMsgReceived += nBytes;
+        }
+    }
+    if (-1 == nBytes && (flags & MSG_DONTWAIT) && (EAGAIN == errno || EWOULDBLOCK == errno)) {
+        // keep on listening for the rest
+        return 1;
+    }
+    if (nBytes > 0) {
+        nBytes = mLongMsgLen;
+        data[mLongMsgLen] = 0;
+        dataCb->onReceive(data, nBytes, &recver);
+    }
+    mLongMsgLen = 0;
+    mLongMsgReceived = 0;
+    return nBytes;
+}
+
+// the slots each take a datagram of up to mMaxTxSize, plus a '\0'
+struct Sock::RecvBatch {
+    static const uint32_t MAX_MSGS = 64;
+    const uint32_t mSlotSize;
+    vector<char> mBuf;
+    vector<struct mmsghdr> mHdrs;
+    vector<struct iovec> mIovs;
+    vector<struct sockaddr_storage> mAddrs;
+    vector<LocIpcMsg> mMsgs;
+    inline RecvBatch(uint32_t maxMsgs, uint32_t maxTxSize) :
+            mSlotSize(maxTxSize + 1), mBuf((size_t)maxMsgs * mSlotSize),
+            mHdrs(maxMsgs), mIovs(maxMsgs), mAddrs(maxMsgs), mMsgs(maxMsgs) {
+        for (uint32_t i = 0; i < maxMsgs; i++) {
+            mIovs[i].iov_base = &mBuf[(size_t)i * mSlotSize];
+            mIovs[i].iov_len = maxTxSize;
+        }
+    }
+    // delivers the msgs collected so far
+    inline void flush(const LocIpcRecver& recver, const shared_ptr<ILocIpcListener>& dataCb,
+                      uint32_t& count) {
+        if (count > 0) {
+            dataCb->onReceiveBatch(mMsgs.data(), count, &recver);
+            count = 0;
+        }
+    }
+};
+bool Sock::enableBatchRecv(uint32_t maxMsgs) {
+    int type = 0;
+    socklen_t optLen = sizeof(type);
+    if (maxMsgs < 2 || !isValid() ||
+        0 != getsockopt(mSid, SOL_SOCKET, SO_TYPE, &type, &optLen) || SOCK_DGRAM != type) {
+        return false;
+    }
+    mRecvBatch = make_shared<RecvBatch>(min(maxMsgs, (uint32_t)RecvBatch::MAX_MSGS), mMaxTxSize);
+    return true;
+}
+// Blocks for the first datagram, then takes the others already pending,
+// and hands the regular msgs among them over in one onReceiveBatch().
+ssize_t Sock::recvBatch(const LocIpcRecver& recver, const shared_ptr<ILocIpcListener>& dataCb,
+                        int sid, int flags, struct sockaddr *srcAddr, socklen_t *addrlen) const {
+    RecvBatch& batch = *mRecvBatch;
+    uint32_t maxMsgs = batch.mHdrs.size();
+    for (uint32_t i = 0; i < maxMsgs; i++) {
+        memset(&batch.mHdrs[i], 0, sizeof(batch.mHdrs[i]));
+        batch.mHdrs[i].msg_hdr.msg_iov = &batch.mIovs[i];
+        batch.mHdrs[i].msg_hdr.msg_iovlen = 1;
+        batch.mHdrs[i].msg_hdr.msg_name = &batch.mAddrs[i];
+        batch.mHdrs[i].msg_hdr.msg_namelen = sizeof(batch.mAddrs[i]);
+    }
+    int n = ::recvmmsg(sid, batch.mHdrs.data(), maxMsgs, flags | MSG_WAITFORONE, nullptr);
+    if (-1 == n && (flags & MSG_DONTWAIT) && (EAGAIN == errno || EWOULDBLOCK == errno)) {
+        // nothing pending after all, keep on listening
+        return 1;
+    }
+    if (n <= 0) {
+        return n;
+    }
+    if (nullptr != srcAddr && nullptr != addrlen) {
+        // the last sender, as if the msgs were received one by one
+        struct msghdr& last = batch.mHdrs[n - 1].msg_hdr;
+        *addrlen = min(*addrlen, last.msg_namelen);
+        memcpy(srcAddr, last.msg_name, *addrlen);
+    }
+
+    ssize_t nBytes = 0;
+    uint32_t count = 0;
+    for (int i = 0; i < n; i++) {
+        char* data = (char*)batch.mIovs[i].iov_base;
+        uint32_t len = batch.mHdrs[i].msg_len;
+        data[len] = 0;
+        if (batch.mHdrs[i].msg_hdr.msg_flags & MSG_TRUNC) {
+            LOC_LOGe("msg truncated to %u bytes, dropped", len);
+        } else if (strncmp(data, MSG_ABORT, sizeof(MSG_ABORT)) == 0) {
+            LOC_LOGi("recvd abort msg.data %s", data);
+            batch.flush(recver, dataCb, count);
+            return 0;
+        } else if (len >= sizeof(FrameHead) &&
+                   0 == memcmp(data, LOC_IPC_BIN_HEAD, sizeof(LOC_IPC_BIN_HEAD))) {
+            // a frame small enough to fit in the slot
+            FrameHead head;
+            memcpy(&head, data, sizeof(head));
+            if (head.mLength == len - sizeof(head)) {
+                batch.mMsgs[count++] = {data + sizeof(head), head.mLength};
+                nBytes += len;
+            }
+        } else if (strncmp(data, LOC_IPC_HEAD, sizeof(LOC_IPC_HEAD) - 1)) {
+            batch.mMsgs[count++] = {data, len};
+            nBytes += len;
+        } else {
+            // long message, whose fragments follow in the batch, or on the socket
+            batch.flush(recver, dataCb, count);
+            uint32_t fragCount = 0;
             size_t msgLen = 0;
-            sscanf(msg.data() + sizeof(LOC_IPC_HEAD) - 1, "%zu", &msgLen);
-            msg.resize(msgLen);
-            for (size_t msgLenReceived = 0; (msgLenReceived < msgLen) && (nBytes > 0);
-                 msgLenReceived += nBytes) {
-                nBytes = ::recvfrom(sid, &(msg[msgLenReceived]), msg.size() - msgLenReceived,
-                                    flags, srcAddr, addrlen);
+            sscanf(data + sizeof(LOC_IPC_HEAD) - 1, "%zu", &msgLen);
+            for (size_t fragLen = 0; i + 1 + fragCount < (uint32_t)n && fragLen < msgLen;
+                 fragCount++) {
+                uint32_t k = i + 1 + fragCount;
+                batch.mMsgs[fragCount] = {(const char*)batch.mIovs[k].iov_base,
+                                          batch.mHdrs[k].msg_len};
+                fragLen += batch.mHdrs[k].msg_len;
             }
-            if (nBytes > 0) {
-                nBytes = msgLen;
-                dataCb->onReceive(msg.data(), nBytes, &recver);
+            ssize_t rtv = recvLongMsg(recver, dataCb, data, batch.mMsgs.data(), fragCount,
+                                      sid, flags, srcAddr, addrlen);
+            if (rtv <= 0) {
+                return rtv;
             }
+            nBytes += rtv;
+            i += fragCount;
         }
     }
+    batch.flush(recver, dataCb, count);
 
-    return nBytes;
+    // the batch may have been all dropped msgs; still keep on listening
+    return (nBytes > 0) ? nBytes : 1;
 }
 ssize_t Sock::sendAbort(int flags, const struct sockaddr *destAddr, socklen_t addrlen) {
     return send(MSG_ABORT, sizeof(MSG_ABORT), flags, destAddr, addrlen);
@@ -138,6 +404,13 @@ protected:
         return mSock->send(data, length, 0, (struct sockaddr*)&mAddr, sizeof(mAddr));
     }
 public:
+    inline virtual bool enableBinaryFraming() override {
+        if (isOperable()) {
+            mSock->enableBinaryFraming();
+            return true;
+        }
+        return false;
+    }
     inline LocIpcLocalSender(const char* name) : LocIpcSender(),
             mSock(nullptr),
             mAddr({.sun_family = AF_UNIX, {}}) {
@@ -182,6 +455,14 @@ public:
     }
     inline virtual ~LocIpcLocalRecver() { unlink(mAddr.sun_path); }
     inline virtual const char* getName() const override { return mAddr.sun_path; };
+    inline virtual int getFd() const override { return mSock->mSid; }
+    inline virtual bool enableBatchRecv(uint32_t maxMsgs) override {
+        return mSock->enableBatchRecv(maxMsgs);
+    }
+    inline virtual bool setNonBlockingRecv(bool nonBlocking) override {
+        mSock->setNonBlockingRecv(nonBlocking);
+        return true;
+    }
     inline virtual void abort() const override {
         if (isSendable()) {
             mSock->sendAbort(0, (struct sockaddr*)&mAddr, sizeof(mAddr));
@@ -189,6 +470,360 @@ public:
     }
 };
 
+// A single producer / single consumer ring in a memfd, mapped by both the
+// sender and the recver process. Each record is a uint32_t length, the
+// payload and a '\0', padded to 8 bytes. A record never wraps; the space
+// left at the end of the ring is skipped with a PAD record instead.
+class LocIpcShmRing {
+public:
+    static const uint32_t DEFAULT_SIZE = 256 * 1024;
+    static const uint32_t MAX_SIZE = 16 * 1024 * 1024;
+private:
+    static const uint32_t MAGIC = 0x4C534852; // "LSHR"
+    static const uint32_t PAD = UINT32_MAX;
+    struct Head {
+        uint32_t mMagic;
+        // of the data area, a power of 2
+        uint32_t mSize;
+        // consumer side
+        alignas(64) std::atomic<uint32_t> mHead;
+        std::atomic<uint32_t> mWaiting;
+        // producer side
+        alignas(64) std::atomic<uint32_t> mTail;
+    };
+    Head* mHead;
+    uint8_t* mData;
+    // of the data area; a private copy of Head::mSize, which the other
+    // process can still write to after it was validated
+    const uint32_t mSize;
+    size_t mMapSize;
+    int mMemFd;
+    // doorbell, written to by the producer if the consumer is waiting
+    int mEventFd;
+    // consumer: the record being delivered, copied out of the ring
+    std::string mRecord;
+    static inline uint32_t recordSize(uint32_t len) {
+        return (sizeof(uint32_t) + len + 1 + 7) & ~7u;
+    }
+    inline LocIpcShmRing(Head* head, uint32_t size, size_t mapSize, int memFd, int eventFd) :
+            mHead(head), mData((uint8_t*)head + sizeof(Head)), mSize(size), mMapSize(mapSize),
+            mMemFd(memFd), mEventFd(eventFd) {}
+public:
+    inline ~LocIpcShmRing() {
+        munmap(mHead, mMapSize);
+        ::close(mMemFd);
+        ::close(mEventFd);
+    }
+    inline int getMemFd() const { return mMemFd; }
+    inline int getEventFd() const { return mEventFd; }
+
+    // producer end
+    static LocIpcShmRing* create(uint32_t size) {
+        uint32_t ringSize = 4096;
+        while (ringSize < size && ringSize < MAX_SIZE) {
+            ringSize <<= 1;
+        }
+        size_t mapSize = sizeof(Head) + ringSize;
+        int memFd = syscall(__NR_memfd_create, "LocIpcShmRing",
+                            MFD_CLOEXEC | MFD_ALLOW_SEALING);
+        int eventFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        void* addr = MAP_FAILED;
+        if (memFd >= 0 && eventFd >= 0 && 0 == ftruncate(memFd, mapSize) &&
+            // the consumer maps the same size, it must not shrink under it
+            0 == fcntl(memFd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL)) {
+            addr = mmap(NULL, mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, memFd, 0);
+        }
+        if (MAP_FAILED == addr) {
+            LOC_LOGe("shm ring create failure - %s", strerror(errno));
+            if (memFd >= 0) ::close(memFd);
+            if (eventFd >= 0) ::close(eventFd);
+            return nullptr;
+        }
+        Head* head = new (addr) Head();
+        head->mMagic = MAGIC;
+        head->mSize = ringSize;
+        return new LocIpcShmRing(head, ringSize, mapSize, memFd, eventFd);
+    }
+
+    // consumer end, takes the ownership of the fds
+    static LocIpcShmRing* attach(int memFd, int eventFd) {
+        struct stat st;
+        void* addr = MAP_FAILED;
+        if (0 == fstat(memFd, &st) && (size_t)st.st_size > sizeof(Head) &&
+            (size_t)st.st_size <= sizeof(Head) + MAX_SIZE &&
+            (F_SEAL_SHRINK & fcntl(memFd, F_GET_SEALS))) {
+            addr = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, memFd, 0);
+        }
+        if (MAP_FAILED != addr) {
+            Head* head = (Head*)addr;
+            uint32_t size = head->mSize;
+            if (MAGIC == head->mMagic && size >= 4096 && 0 == (size & (size - 1)) &&
+                sizeof(Head) + size == (size_t)st.st_size) {
+                return new LocIpcShmRing(head, size, st.st_size, memFd, eventFd);
+            }
+            munmap(addr, st.st_size);
+        }
+        LOC_LOGe("shm ring attach failure");
+        ::close(memFd);
+        ::close(eventFd);
+        return nullptr;
+    }
+
+    // false if the ring is too full, or len too large for it
+    LOC_IPC_WRAPS bool push(const uint8_t* data, uint32_t len) {
+        uint32_t size = mSize;
+        uint32_t need = recordSize(len);
+        if (len > size / 2 || need > size / 2) {
+            return false;
+        }
+        uint32_t tail = mHead->mTail.load(std::memory_order_relaxed);
+        uint32_t used = tail - mHead->mHead.load(std::memory_order_acquire);
+        uint32_t offset = tail & (size - 1);
+        uint32_t toEnd = size - offset;
+        uint32_t total = (need > toEnd) ? (toEnd + need) : need;
+        if (size - used < total) {
+            return false;
+        }
+        if (need > toEnd) {
+            *(uint32_t*)(mData + offset) = PAD;
+            tail += toEnd;
+            offset = 0;
+        }
+        *(uint32_t*)(mData + offset) = len;
+        memcpy(mData + offset + sizeof(uint32_t), data, len);
+        mData[offset + sizeof(uint32_t) + len] = 0;
+        // seq_cst, so that it is ordered before reading mWaiting, against
+        // the consumer setting mWaiting before reading mTail
+        mHead->mTail.store(tail + need);
+        if (mHead->mWaiting.load()) {
+            uint64_t one = 1;
+            (void)write(mEventFd, &one, sizeof(one));
+        }
+        return true;
+    }
+
+    // hands the records in the ring to cb; returns the count. Each record is
+    // copied out of the ring first, as the producer can still rewrite it in
+    // place after it was validated
+    template <typename CB>
+    LOC_IPC_WRAPS uint32_t drain(CB cb) {
+        uint32_t size = mSize;
+        uint32_t head = mHead->mHead.load(std::memory_order_relaxed);
+        uint32_t tail = mHead->mTail.load(std::memory_order_acquire);
+        uint32_t count = 0;
+        while (head != tail) {
+            uint32_t offset = head & (size - 1);
+            uint32_t avail = tail - head;
+            uint32_t len = *(volatile uint32_t*)(mData + offset);
+            uint32_t step = (PAD == len) ? (size - offset) : recordSize(len);
+            // the producer is in another process, trust nothing
+            if (avail > size || (PAD != len && len > size / 2) ||
+                step > avail || step > size - offset) {
+                LOC_LOGe("shm ring corrupted, %u bytes dropped", avail);
+                head = tail;
+            } else {
+                if (PAD != len) {
+                    mRecord.assign((const char*)mData + offset + sizeof(uint32_t), len);
+                    cb(mRecord.c_str(), len);
+                    count++;
+                }
+                head += step;
+            }
+            mHead->mHead.store(head, std::memory_order_release);
+        }
+        return count;
+    }
+
+    // consumer: set before the last check for data and waiting on the
+    // eventfd; seq_cst against push()
+    inline void setWaiting(bool waiting) { mHead->mWaiting.store(waiting ? 1 : 0); }
+    inline bool isEmpty() const {
+        return mHead->mTail.load() == mHead->mHead.load(std::memory_order_relaxed);
+    }
+    // producer: how far the consumer has drained
+    inline uint32_t getConsumed() const {
+        return mHead->mHead.load(std::memory_order_relaxed);
+    }
+};
+
+static const char LOC_IPC_SHM_ATTACH[] = "$LOCSHM";
+
+class LocIpcShmSender : public LocIpcLocalSender {
+    unique_ptr<LocIpcShmRing> mRing;
+    mutable mutex mMutex;
+    mutable bool mAttached;
+    // consumer position when the ring was last found full, and when the
+    // ring was last offered again
+    mutable uint32_t mFullConsumed;
+    mutable uint64_t mReattachNs;
+    static const uint64_t REATTACH_INTERVAL_NS = 1000000000ULL;
+    // passes the fds of the ring to the recver
+    bool sendAttach() const {
+        int fds[2] = {mRing->getMemFd(), mRing->getEventFd()};
+        union {
+            char buf[CMSG_SPACE(sizeof(fds))];
+            struct cmsghdr align;
+        } control;
+        memset(&control, 0, sizeof(control));
+        struct iovec iov = {(void*)LOC_IPC_SHM_ATTACH, sizeof(LOC_IPC_SHM_ATTACH)};
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_name = (void*)&mAddr;
+        msg.msg_namelen = sizeof(mAddr);
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control.buf;
+        msg.msg_controllen = sizeof(control.buf);
+        struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+        memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+        return ::sendmsg(mSock->mSid, &msg, 0) > 0;
+    }
+protected:
+    inline virtual bool isOperable() const override {
+        return LocIpcLocalSender::isOperable() && mRing != nullptr;
+    }
+    virtual ssize_t send(const uint8_t data[], uint32_t length, int32_t /* msgId */) const {
+        lock_guard<mutex> lock(mMutex);
+        if (!mAttached) {
+            mAttached = sendAttach();
+            if (!mAttached) {
+                LOC_LOGw("%s: recver not ready - %s", mAddr.sun_path, strerror(errno));
+                return -1;
+            }
+        }
+        if (mRing->push(data, length)) {
+            return length;
+        }
+        // the recver may have restarted and not be draining this ring; if it
+        // made no progress since the ring was last full, offer the ring again,
+        // at most once per REATTACH_INTERVAL_NS. Attaching the same ring again
+        // is a no op for a recver that has it.
+        LOC_LOGw("%s: shm ring full, %u bytes dropped", mAddr.sun_path, length);
+        uint32_t consumed = mRing->getConsumed();
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        uint64_t nowNs = (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+        if (consumed == mFullConsumed && nowNs - mReattachNs >= REATTACH_INTERVAL_NS) {
+            sendAttach();
+            mReattachNs = nowNs;
+        }
+        mFullConsumed = consumed;
+        return -1;
+    }
+public:
+    inline LocIpcShmSender(const char* name, uint32_t ringSize) :
+            LocIpcLocalSender(name),
+            mRing(LocIpcShmRing::create(ringSize ? ringSize : LocIpcShmRing::DEFAULT_SIZE)),
+            mAttached(false), mFullConsumed(0), mReattachNs(0) {}
+};
+
+class LocIpcShmRecver : public LocIpcLocalRecver {
+    mutable unique_ptr<LocIpcShmRing> mRing;
+    mutable ino_t mRingIno;
+    // takes the fds of a ring from an attach msg
+    void attach() const {
+        int fds[2] = {-1, -1};
+        char buf[sizeof(LOC_IPC_SHM_ATTACH)];
+        union {
+            char buf[CMSG_SPACE(sizeof(fds))];
+            struct cmsghdr align;
+        } control;
+        struct iovec iov = {buf, sizeof(buf)};
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control.buf;
+        msg.msg_controllen = sizeof(control.buf);
+        if (::recvmsg(mSock->mSid, &msg, MSG_CMSG_CLOEXEC) > 0) {
+            struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+            if (nullptr != cmsg && SOL_SOCKET == cmsg->cmsg_level &&
+                SCM_RIGHTS == cmsg->cmsg_type && CMSG_LEN(sizeof(fds)) == cmsg->cmsg_len) {
+                memcpy(fds, CMSG_DATA(cmsg), sizeof(fds));
+            } else if (nullptr != cmsg && SCM_RIGHTS == cmsg->cmsg_type) {
+                // don't leak whatever else came in
+                int n = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+                for (int i = 0; i < n; i++) {
+                    ::close(((int*)CMSG_DATA(cmsg))[i]);
+                }
+            }
+        }
+        struct stat st;
+        if (fds[0] < 0 || fds[1] < 0 || 0 != fstat(fds[0], &st)) {
+            LOC_LOGe("%s: bad shm attach msg", mAddr.sun_path);
+        } else if (mRing != nullptr && st.st_ino == mRingIno) {
+            // the ring we have already
+        } else {
+            if (mRing != nullptr) {
+                LOC_LOGw("%s: shm ring replaced", mAddr.sun_path);
+            }
+            mRing.reset(LocIpcShmRing::attach(fds[0], fds[1]));
+            mRingIno = st.st_ino;
+            return;
+        }
+        if (fds[0] >= 0) ::close(fds[0]);
+        if (fds[1] >= 0) ::close(fds[1]);
+    }
+protected:
+    // returns after having delivered at least one msg, or on abort / error
+    virtual ssize_t recv() const override {
+        for (;;) {
+            if (mRing != nullptr) {
+                ssize_t count = mRing->drain([this] (const char* data, uint32_t len) {
+                    mDataCb->onReceive(data, len, this);
+                });
+                if (count > 0) {
+                    return count;
+                }
+                mRing->setWaiting(true);
+                if (!mRing->isEmpty()) {
+                    mRing->setWaiting(false);
+                    continue;
+                }
+            }
+            struct pollfd fds[2] = {
+                {mSock->mSid, POLLIN, 0},
+                {(mRing != nullptr) ? mRing->getEventFd() : -1, POLLIN, 0}
+            };
+            int rtv = poll(fds, 2, -1);
+            if (mRing != nullptr) {
+                mRing->setWaiting(false);
+            }
+            if (rtv < 0) {
+                if (EINTR == errno) {
+                    continue;
+                }
+                return -1;
+            }
+            if (fds[1].revents & POLLIN) {
+                uint64_t count;
+                (void)read(fds[1].fd, &count, sizeof(count));
+            }
+            if (fds[0].revents & (POLLIN | POLLERR | POLLHUP)) {
+                char head[sizeof(LOC_IPC_SHM_ATTACH)] = {0};
+                if (::recv(mSock->mSid, head, sizeof(head), MSG_PEEK | MSG_DONTWAIT) ==
+                        sizeof(head) && 0 == memcmp(head, LOC_IPC_SHM_ATTACH, sizeof(head))) {
+                    attach();
+                } else {
+                    // a msg from a plain local sender, or abort
+                    return LocIpcLocalRecver::recv();
+                }
+            }
+        }
+    }
+public:
+    inline LocIpcShmRecver(const shared_ptr<ILocIpcListener>& listener, const char* name) :
+            LocIpcLocalRecver(listener, name), mRingIno(0) {}
+    // it waits on the socket and the doorbell both, so it can't be polled
+    // by a LocEventLoop on one fd
+    inline virtual int getFd() const override { return -1; }
+    // an attach msg taken in a batch would be missed for its fds
+    inline virtual bool enableBatchRecv(uint32_t /*maxMsgs*/) override { return false; }
+};
+
 class LocIpcInetSender : public LocIpcSender {
 protected:
     int mSockType;
@@ -221,6 +856,13 @@ public:
     unique_ptr<LocIpcRecver> getRecver(const shared_ptr<ILocIpcListener>& listener) override {
         return make_unique<SockRecver>(listener, *this, mSock);
     }
+    inline virtual bool enableBinaryFraming() override {
+        if (isOperable() && SOCK_DGRAM == mSockType) {
+            mSock->enableBinaryFraming();
+            return true;
+        }
+        return false;
+    }
 };
 
 class LocIpcInetTcpSender : public LocIpcInetSender {
@@ -302,6 +944,14 @@ public:
             LocIpcInetRecver(listener, name, port, SOCK_DGRAM) {}
 
     inline virtual ~LocIpcInetUdpRecver() {}
+    inline virtual int getFd() const override { return mSock->mSid; }
+    inline virtual bool enableBatchRecv(uint32_t maxMsgs) override {
+        return mSock->enableBatchRecv(maxMsgs);
+    }
+    inline virtual bool setNonBlockingRecv(bool nonBlocking) override {
+        mSock->setNonBlockingRecv(nonBlocking);
+        return true;
+    }
 };
 
 class LocIpcRunnable : public LocRunnable {
@@ -342,6 +992,62 @@ bool LocIpc::startNonBlockingListening(unique_ptr<LocIpcRecver>& ipcRecver) {
     }
 }
 
+// Receives in the LocEventLoop thread, one message per readable event. The
+// receives must not block the loop, so a message sent in fragments is
+// assembled over as many events as it takes.
+class LocIpcLoopHandler : public LocEventHandler {
+    LocEventLoop& mLoop;
+    unique_ptr<LocIpcRecver> mIpcRecver;
+    const int mFd;
+    std::atomic<bool> mListening;
+public:
+    inline LocIpcLoopHandler(LocEventLoop& loop, unique_ptr<LocIpcRecver>& ipcRecver) :
+            mLoop(loop), mIpcRecver(move(ipcRecver)), mFd(mIpcRecver->getFd()),
+            mListening(false) {}
+    inline bool start() {
+        if (!mIpcRecver->setNonBlockingRecv(true)) {
+            return false;
+        }
+        mIpcRecver->onListenerReady();
+        mListening = mLoop.addFd(mFd, EPOLLIN, *this);
+        return mListening;
+    }
+    inline void stop() {
+        mLoop.removeFd(mFd);
+        mListening = false;
+    }
+    inline bool isListening() const { return mListening; }
+    // hands the recver back after start() failed, so that it can be retried
+    inline void releaseRecver(unique_ptr<LocIpcRecver>& ipcRecver) {
+        mIpcRecver->setNonBlockingRecv(false);
+        ipcRecver = move(mIpcRecver);
+    }
+    virtual void onEvent(int /*fd*/, uint32_t /*events*/) override {
+        if (!mIpcRecver->recvData()) {
+            LOC_LOGw("%s: recvData() failed, stop listening", mIpcRecver->getName());
+            stop();
+        }
+    }
+};
+
+bool LocIpc::startNonBlockingListening(unique_ptr<LocIpcRecver>& ipcRecver, LocEventLoop& loop) {
+    if (ipcRecver != nullptr && ipcRecver->isRecvable() && ipcRecver->getFd() >= 0) {
+        if ((mLoopHandler != nullptr && mLoopHandler->isListening()) || mThread.isRunning()) {
+            LOC_LOGe("already listening");
+            return false;
+        }
+        mLoopHandler = make_shared<LocIpcLoopHandler>(loop, ipcRecver);
+        if (!mLoopHandler->start()) {
+            mLoopHandler->releaseRecver(ipcRecver);
+            mLoopHandler = nullptr;
+            return false;
+        }
+        return true;
+    } else {
+        return startNonBlockingListening(ipcRecver);
+    }
+}
+
 bool LocIpc::startBlockingListening(LocIpcRecver& ipcRecver) {
     if (ipcRecver.isRecvable()) {
         // inform that the socket is ready to receive message
@@ -355,6 +1061,10 @@ bool LocIpc::startBlockingListening(LocIpcRecver& ipcRecver) {
 }
 
 void LocIpc::stopNonBlockingListening() {
+    if (mLoopHandler != nullptr) {
+        mLoopHandler->stop();
+        mLoopHandler = nullptr;
+    }
     mThread.stop();
 }
 
@@ -375,6 +1085,14 @@ unique_ptr<LocIpcRecver> LocIpc::getLocIpcLocalRecver(const shared_ptr<ILocIpcLi
                                                       const char* localSockName) {
     return make_unique<LocIpcLocalRecver>(listener, localSockName);
 }
+shared_ptr<LocIpcSender> LocIpc::getLocIpcShmSender(const char* localSockName,
+                                                    uint32_t ringSize) {
+    return make_shared<LocIpcShmSender>(localSockName, ringSize);
+}
+unique_ptr<LocIpcRecver> LocIpc::getLocIpcShmRecver(const shared_ptr<ILocIpcListener>& listener,
+                                                    const char* localSockName) {
+    return make_unique<LocIpcShmRecver>(listener, localSockName);
+}
 static void* sLibQrtrHandle = nullptr;
 static const char* sLibQrtrName = "libloc_socket.so";
 shared_ptr<LocIpcSender> LocIpc::getLocIpcQrtrSender(int service, int instance) {
@@ -36,8 +36,10 @@
 #include <sys/socket.h>
 #include <sys/un.h>
 #include <unordered_set>
+#include <vector>
 #include <mutex>
 #include <LocThread.h>
+#include <LocEventLoop.h>
 
 using namespace std;
 
@@ -45,6 +47,12 @@ namespace loc_util {
 
 class LocIpcRecver;
 class LocIpcSender;
+class LocIpcLoopHandler;
+
+struct LocIpcMsg {
+    const char* data;
+    uint32_t len;
+};
 
 class ILocIpcListener {
 protected:
@@ -54,6 +62,15 @@ public:
     // when the socket for LocIpc is ready to receive messages.
     inline virtual void onListenerReady() {}
     virtual void onReceive(const char* data, uint32_t len, const LocIpcRecver* recver) = 0;
+    // LocIpc client can overwrite this function to take all the messages
+    // a recver in batch mode gets in one wakeup at once, e.g. to handle
+    // them in one MsgTask msg. The data are only valid in this call.
+    inline virtual void onReceiveBatch(const LocIpcMsg msgs[], uint32_t count,
+                                       const LocIpcRecver* recver) {
+        for (uint32_t i = 0; i < count; i++) {
+            onReceive(msgs[i].data, msgs[i].len, recver);
+        }
+    }
 };
 
 class LocIpcQrtrWatcher {
@@ -105,6 +122,17 @@ public:
     static unique_ptr<LocIpcRecver>
             getLocIpcLocalRecver(const shared_ptr<ILocIpcListener>& listener,
                                  const char* localSockName);
+    // Shared memory transport between two local processes. The sender
+    // creates a ring of ringSize bytes (0 for default), and hands it over
+    // to the recver bound at localSockName with its first send. Messages
+    // then go through the ring, with no syscall unless the recver is
+    // waiting. The recver still takes messages from the socket, e.g. from
+    // local senders. There can only be one shm sender per recver.
+    static shared_ptr<LocIpcSender>
+            getLocIpcShmSender(const char* localSockName, uint32_t ringSize = 0);
+    static unique_ptr<LocIpcRecver>
+            getLocIpcShmRecver(const shared_ptr<ILocIpcListener>& listener,
+                               const char* localSockName);
     static unique_ptr<LocIpcRecver>
             getLocIpcInetUdpRecver(const shared_ptr<ILocIpcListener>& listener,
                                  const char* serverName, int32_t port);
@@ -139,6 +167,12 @@ public:
     bool startNonBlockingListening(unique_ptr<LocIpcRecver>& ipcRecver);
     void stopNonBlockingListening();
 
+    // Listen for new messages in the thread of loop, which is shared with
+    // the other fds polled by it, instead of a new LocThread.
+    // Falls back to a new LocThread if ipcRecver has no fd to poll on.
+    // The listening can be stopped by calling stopNonBlockingListening().
+    bool startNonBlockingListening(unique_ptr<LocIpcRecver>& ipcRecver, LocEventLoop& loop);
+
     // Send out a message.
     // Call this function to send a message in argument data to socket in argument name.
     //
@@ -150,6 +184,7 @@ public:
 
 private:
     LocThread mThread;
+    shared_ptr<LocIpcLoopHandler> mLoopHandler;
 };
 
 /* this is only when client needs to implement Sender / Recver that are not already provided by
@@ -170,6 +205,11 @@ public:
         return nullptr;
     }
     inline virtual void copyDestAddrFrom(const LocIpcSender& otherSender) {}
+    // Messages longer than the max tx size are sent as one binary framed
+    // datagram, instead of being fragmented after a text header. The peer
+    // must be a LocIpc recver, and be enabled too for receiving them.
+    // return: true if the sender supports it, i.e. is datagram based.
+    inline virtual bool enableBinaryFraming() { return false; }
 };
 
 class LocIpcRecver {
@@ -185,25 +225,71 @@ public:
     virtual ~LocIpcRecver() = default;
     inline bool recvData() const { return isRecvable() && (recv() > 0); }
     inline bool isRecvable() const { return mDataCb != nullptr && mIpcSender.isSendable(); }
+    // sizes the socket and receive buffer for binary framed messages
+    inline bool enableBinaryFraming() { return mIpcSender.enableBinaryFraming(); }
     virtual void onListenerReady() { if (mDataCb != nullptr) mDataCb->onListenerReady(); }
     inline virtual unique_ptr<LocIpcSender> getLastSender() const {
         return nullptr;
     }
     virtual void abort() const = 0;
     virtual const char* getName() const = 0;
+    // fd that becomes readable when recvData() would not block, -1 if none
+    inline virtual int getFd() const { return -1; }
+    // Takes up to maxMsgs pending datagrams per recvData(), with one
+    // recvmmsg(), and hands them to ILocIpcListener::onReceiveBatch().
+    // return: true if the recver supports it, i.e. is datagram based.
+    inline virtual bool enableBatchRecv(uint32_t /*maxMsgs*/) { return false; }
+    // Makes recvData() return instead of blocking when no data is pending,
+    // as it does in a LocEventLoop, which calls it once the fd is readable.
+    // return: true if the recver supports it, i.e. it has an fd.
+    inline virtual bool setNonBlockingRecv(bool /*nonBlocking*/) { return false; }
 };
 
 class Sock {
     static const char MSG_ABORT[];
     static const char LOC_IPC_HEAD[];
+    static const char LOC_IPC_BIN_HEAD[];
+    // upper limit of a binary framed message
+    static const uint32_t MAX_FRAME_SIZE = 256 * 1024;
+    struct FrameHead {
+        char mMagic[8];
+        uint32_t mLength;
+        uint32_t mReserved;
+    };
     const uint32_t mMaxTxSize;
+    bool mBinaryFraming;
+    bool mNonBlockingRecv;
+    // reused by every receive, so that it doesn't allocate per message
+    mutable vector<char> mRecvBuf;
+    // length of the long message being assembled in mRecvBuf, and how much
+    // of it has been received; its fragments may span several receives when
+    // they do not block
+    mutable size_t mLongMsgLen;
+    mutable size_t mLongMsgReceived;
+    // buffers of the batch mode, if enabled
+    struct RecvBatch;
+    shared_ptr<RecvBatch> mRecvBatch;
     ssize_t sendto(const void *buf, size_t len, int flags, const struct sockaddr *destAddr,
                    socklen_t addrlen) const;
+    ssize_t sendFramed(const void *buf, size_t len, int flags, const struct sockaddr *destAddr,
+                       socklen_t addrlen) const;
     ssize_t recvfrom(const LocIpcRecver& recver, const shared_ptr<ILocIpcListener>& dataCb,
                      int sid, int flags, struct sockaddr *srcAddr, socklen_t *addrlen) const;
+    ssize_t recvBatch(const LocIpcRecver& recver, const shared_ptr<ILocIpcListener>& dataCb,
+                      int sid, int flags, struct sockaddr *srcAddr, socklen_t *addrlen) const;
+    ssize_t recvLongMsg(const LocIpcRecver& recver, const shared_ptr<ILocIpcListener>& dataCb,
+                        const char* head, const LocIpcMsg* frags, uint32_t fragCount,
+                        int sid, int flags, struct sockaddr *srcAddr, socklen_t *addrlen) const;
+    ssize_t recvLongMsgRest(const LocIpcRecver& recver,
+                            const shared_ptr<ILocIpcListener>& dataCb,
+                            int sid, int flags, struct sockaddr *srcAddr,
+                            socklen_t *addrlen) const;
+    size_t recvBufSize() const;
 public:
     int mSid;
-    inline Sock(int sid, const uint32_t maxTxSize = 8192) : mMaxTxSize(maxTxSize), mSid(sid) {}
+    inline Sock(int sid, const uint32_t maxTxSize = 8192) :
+            mMaxTxSize(maxTxSize), mBinaryFraming(false), mNonBlockingRecv(false),
+            mLongMsgLen(0), mLongMsgReceived(0), mSid(sid) {}
     inline ~Sock() { close(); }
     inline bool isValid() const { return -1 != mSid; }
     ssize_t send(const void *buf, uint32_t len, int flags, const struct sockaddr *destAddr,
@@ -211,6 +297,13 @@ public:
     ssize_t recv(const LocIpcRecver& recver, const shared_ptr<ILocIpcListener>& dataCb, int flags,
                  struct sockaddr *srcAddr, socklen_t *addrlen, int sid = -1) const;
     ssize_t sendAbort(int flags, const struct sockaddr *destAddr, socklen_t addrlen);
+    // only for datagram sockets, as a frame must arrive in one piece
+    void enableBinaryFraming();
+    // only for datagram sockets; not used along with binary framing, whose
+    // frames would not fit in the batch slots
+    bool enableBatchRecv(uint32_t maxMsgs);
+    // receives with MSG_DONTWAIT, see LocIpcRecver::setNonBlockingRecv()
+    inline void setNonBlockingRecv(bool nonBlocking) { mNonBlockingRecv = nonBlocking; }
     inline void close() {
         if (isValid()) {
             ::close(mSid);
@@ -234,6 +327,14 @@ public:
         return "SockRecver";
     }
     inline virtual void abort() const override {}
+    inline virtual int getFd() const override { return mSock->mSid; }
+    inline virtual bool enableBatchRecv(uint32_t maxMsgs) override {
+        return mSock->enableBatchRecv(maxMsgs);
+    }
+    inline virtual bool setNonBlockingRecv(bool nonBlocking) override {
+        mSock->setNonBlockingRecv(nonBlocking);
+        return true;
+    }
 };
 
 }
@@ -32,13 +32,14 @@
 #include <stdlib.h>
 #include <time.h>
 #include <errno.h>
+#include <atomic>
 #include <sys/timerfd.h>
 #include <sys/epoll.h>
 #include <log_util.h>
 #include <loc_timer.h>
 #include <LocTimer.h>
 #include <LocHeap.h>
-#include <LocThread.h>
+#include <LocEventLoop.h>
 #include <LocSharedLock.h>
 #include <MsgTask.h>
 
@@ -67,17 +68,21 @@ LocTimerDelegate - an internal timer entity, which also is a LocRankable obj.
                    heap, its ranks() implementation decides where it is placed
                    in the heap.
 LocTimerContainer - core of the timer service. It is a container (derived from
-                    LocHeap) for LocTimerDelegate (implements LocRankable) objs.
+                    LocIndexedHeap) for LocTimerDelegate (implements LocRankable) objs.
                     There are 2 of such containers, one for sw timers (or Linux
                     timers) one for hw timers (or Linux alarms). It adds one of
                     each (those that expire the soonest) to kernel via services
                     provided by LocTimerPollTask. All the heap management on the
                     LocTimerDelegate objs are done in the MsgTask context, such
                     that synchronization is ensured.
-LocTimerPollTask - is a class that wraps timerfd and epoll POXIS APIs. It also
-                   both implements LocRunnalbe with epoll_wait() in the run()
-                   method. It is also a LocThread client, so as to loop the run
-                   method.
+                    When a slack is configured, the container for sw timers
+                    is instead a hashed timing wheel, whose tick is the slack.
+                    Timers are rounded up to the next tick, which makes start /
+                    stop O(1) and lets all timers due in a tick expire on one
+                    timerfd wakeup.
+LocTimerPollTask - is a class that adds / removes the timerfds of the containers
+                   to / from the process wide LocEventLoop, which epolls them
+                   along with the other fds of the process in one thread.
 LocTimerWrapper - a LocTimer client itself, to implement the existing C API with
                   APIs, loc_timer_start() and loc_timer_stop().
 
@@ -86,14 +91,14 @@ LocTimerWrapper - a LocTimer client itself, to implement the existing C API with
 class LocTimerPollTask;
 
 // This is a multi-functaional class that:
-// * extends the LocHeap class for the detection of head update upon add / remove
+// * extends the LocIndexedHeap class for the detection of head update upon add / remove
 //   events. When that happens, soonest time out changes, so timerfd needs update.
 // * contains the timers, and add / remove them into the heap
 // * provides and maps 2 of such containers, one for timers (or  mSwTimers), one
 //   for alarms (or mHwTimers);
-// * provides a polling thread;
+// * is polled by the LocEventLoop, as a LocEventHandler;
 // * provides a MsgTask thread for synchronized add / remove / timer client callback.
-class LocTimerContainer : public LocHeap {
+class LocTimerContainer : public LocIndexedHeap, public LocEventHandler {
     // mutex to synchronize getters of static members
     static pthread_mutex_t mMutex;
     // Container of timers
@@ -102,24 +107,49 @@ class LocTimerContainer : public LocHeap {
     static LocTimerContainer* mHwTimers;
     // Msg task to provider msg Q, sender and reader.
     static MsgTask* mMsgTask;
-    // Poll task to provide epoll call and threading to poll.
+    // Poll task to add / remove timer fds to / from the event loop.
     static LocTimerPollTask* mPollTask;
+    // slack in ms applied to the sw timers, 0 if timers are exact
+    static std::atomic<uint32_t> mSlackMs;
     // timer / alarm fd
     int mDevFd;
+
+    // timing wheel, only in use if mTickNs is non 0
+    static const uint32_t WHEEL_SIZE = 256;
+    static const uint64_t NO_TICK = UINT64_MAX;
+    struct WheelBucket {
+        LocTimerDelegate* mHead;
+        // no timer in the bucket expires before this tick; may be stale low
+        uint64_t mMinTick;
+    };
+    uint64_t mTickNs;
+    WheelBucket* mWheel;
+    uint32_t mWheelCount;
+    // the last tick that all buckets have been expired up to
+    uint64_t mWheelCursor;
+    // the tick timerfd is armed to, NO_TICK if disarmed
+    uint64_t mArmedTick;
+
     // ctor
     LocTimerContainer(bool wakeOnExpire);
     // dtor
     ~LocTimerContainer();
     static MsgTask* getMsgTaskLocked();
     static LocTimerPollTask* getPollTaskLocked();
-    // extend LocHeap and pop if the top outRanks input
+    // extend LocIndexedHeap and pop if the top outRanks input
     LocTimerDelegate* popIfOutRanks(LocTimerDelegate& timer);
     // update the timer POSIX calls with updated soonest timer spec
     void updateSoonestTime(LocTimerDelegate* priorTop);
+    // timing wheel counter parts of the heap management
+    void wheelPush(LocTimerDelegate& timer);
+    void wheelRemove(LocTimerDelegate& timer);
+    void wheelExpire();
+    void armWheel(uint64_t tick);
 
 public:
     // factory method to control the creation of mSwTimers / mHwTimers
     static LocTimerContainer* get(bool wakeOnExpire);
+    static inline void setSlack(uint32_t slackMs) { mSlackMs = slackMs; }
 
     LocTimerDelegate* getSoonestTimer();
     int getTimerFd();
@@ -129,27 +159,14 @@ public:
     void remove(LocTimerDelegate& timer);
     // handling of timer / alarm expiration
     void expire();
+    // LocEventHandler method, called by the LocEventLoop when timerfd fires
+    inline virtual void onEvent(int /*fd*/, uint32_t /*events*/) override { expire(); }
 };
 
-class TimerRunnable : public LocRunnable {
-    const int mFd;
-public:
-    inline TimerRunnable(const int fd) : mFd(fd) {}
-    // The method to be implemented by thread clients
-    // and be scheduled by LocThread
-    // This method will be repeated called until it returns false; or
-    // until thread is stopped.
-    virtual bool run() override;
-
-    // The method to wake up the potential blocking thread
-    // no op if not applicable
-    inline virtual void interrupt() { close(mFd); }
-};
-
-// This class implements the polling thread that epolls imer / alarm fds.
-// The LocRunnable::run() contains the actual polling.  The other methods
-// will be run in the caller's thread context to add / remove timer / alarm
-// fds the kernel, while the polling is blocked on epoll_wait() call.
+// This class hands the timer / alarm fds to the LocEventLoop of the process,
+// whose thread does the actual polling.  The methods run in the caller's
+// thread context to add / remove timer / alarm fds, while the polling is
+// blocked on epoll_wait() call.
 // Since the design is that we have maximally 2 polls, one for all the
 // timers; one for all the alarms, we will poll at most on 2 fds.  But it
 // is possile that all we have are only timers or alarms at one time, so we
@@ -158,11 +175,7 @@ public:
 // to make a system call each time a timer / alarm is added / removed, unless
 // that changes the "soonest" time out of that of all the timers / alarms.
 class LocTimerPollTask {
-    // the epoll fd
-    const int mFd;
-    // the thread that calls TimerRunnable::run() method, where
-    // epoll_wait() is blocking and waiting for events..
-    LocThread mThread;
+    LocEventLoop& mLoop;
 public:
     // ctor
     LocTimerPollTask();
@@ -172,9 +185,8 @@ public:
     // either timer or alarm fd, and a heap of timers / alarms. It is expected
     // that container would have written to the device fd with the soonest
     // time out value in the heap at the time of calling this method. So all
-    // this method does is to add the fd of the input container to the poll
-    // and also add the pointer of the container to the event data ptr, such
-    // when poll_wait wakes up on events, we know who is the owner of the fd.
+    // this method does is to add the fd of the input container to the poll,
+    // with the container as the handler of its events.
     void addPoll(LocTimerContainer& timerContainer);
     // remove a fd that is assciated with a container. The expectation is that
     // the atual timer would have been removed from the container.
@@ -192,9 +204,15 @@ class LocTimerDelegate : public LocRankable {
     LocSharedLock* mLock;
     struct timespec mFutureTime;
     LocTimerContainer* mContainer;
+    // links in the timing wheel bucket, and the tick to expire at;
+    // mWheelTick is 0 when not in the wheel
+    LocTimerDelegate* mWheelPrev;
+    LocTimerDelegate* mWheelNext;
+    uint64_t mWheelTick;
     // not a complete obj, just ctor for LocRankable comparisons
     inline LocTimerDelegate(struct timespec& delay)
-        : mClient(NULL), mLock(NULL), mFutureTime(delay), mContainer(NULL) {}
+        : mClient(NULL), mLock(NULL), mFutureTime(delay), mContainer(NULL),
+          mWheelPrev(NULL), mWheelNext(NULL), mWheelTick(0) {}
     inline ~LocTimerDelegate() { if (mLock) { mLock->drop(); mLock = NULL; } }
 public:
     LocTimerDelegate(LocTimer& client, struct timespec& futureTime, LocTimerContainer* container);
@@ -217,12 +235,34 @@ LocTimerContainer* LocTimerContainer::mSwTimers = NULL;
 LocTimerContainer* LocTimerContainer::mHwTimers = NULL;
 MsgTask* LocTimerContainer::mMsgTask = NULL;
 LocTimerPollTask* LocTimerContainer::mPollTask = NULL;
+std::atomic<uint32_t> LocTimerContainer::mSlackMs(0);
+
+static inline uint64_t timespecToNs(const struct timespec& ts) {
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
 
 // ctor - initialize timer heaps
 // A container for swTimer (timer) is created, when wakeOnExpire is true; or
 // HwTimer (alarm), when wakeOnExpire is false.
+// The mode of the container for non wakeup timers is decided here, by the
+// slack configured at the time the first such timer starts.
 LocTimerContainer::LocTimerContainer(bool wakeOnExpire) :
-    mDevFd(timerfd_create(wakeOnExpire ? CLOCK_BOOTTIME_ALARM : CLOCK_BOOTTIME, 0)) {
+    mDevFd(timerfd_create(wakeOnExpire ? CLOCK_BOOTTIME_ALARM : CLOCK_BOOTTIME, 0)),
+    mTickNs(wakeOnExpire ? 0 : (uint64_t)mSlackMs * 1000000ULL),
+    mWheel(NULL), mWheelCount(0), mWheelCursor(0), mArmedTick(NO_TICK) {
+
+    if (0 != mTickNs) {
+        mWheel = new WheelBucket[WHEEL_SIZE];
+        for (uint32_t i = 0; i < WHEEL_SIZE; i++) {
+            mWheel[i].mHead = NULL;
+            mWheel[i].mMinTick = NO_TICK;
+        }
+        struct timespec now;
+        clock_gettime(CLOCK_BOOTTIME, &now);
+        mWheelCursor = timespecToNs(now) / mTickNs;
+        LOC_LOGD("%s: timing wheel with %u ms tick", __FUNCTION__,
+                 (uint32_t)(mTickNs / 1000000));
+    }
 
     if ((-1 == mDevFd) && (errno == EINVAL)) {
         LOC_LOGW("%s: timerfd_create failure, fallback to CLOCK_MONOTONIC - %s",
@@ -244,6 +284,7 @@ LocTimerContainer::LocTimerContainer(bool wakeOnExpire) :
 inline
 LocTimerContainer::~LocTimerContainer() {
     close(mDevFd);
+    delete[] mWheel;
 }
 
 LocTimerContainer* LocTimerContainer::get(bool wakeOnExpire) {
@@ -329,6 +370,10 @@ void LocTimerContainer::add(LocTimerDelegate& timer) {
         inline MsgTimerPush(LocTimerContainer& container, LocTimerDelegate& timer) :
             LocMsg(), mTimerContainer(&container), mTimer(&timer) {}
         inline virtual void proc() const {
+            if (mTimerContainer->mWheel) {
+                mTimerContainer->wheelPush(*mTimer);
+                return;
+            }
             LocTimerDelegate* priorTop = mTimerContainer->getSoonestTimer();
             mTimerContainer->push((LocRankable&)(*mTimer));
             mTimerContainer->updateSoonestTime(priorTop);
@@ -346,11 +391,17 @@ void LocTimerContainer::remove(LocTimerDelegate& timer) {
         inline MsgTimerRemove(LocTimerContainer& container, LocTimerDelegate& timer) :
             LocMsg(), mTimerContainer(&container), mTimer(&timer) {}
         inline virtual void proc() const {
+            if (mTimerContainer->mWheel) {
+                mTimerContainer->wheelRemove(*mTimer);
+                delete mTimer;
+                return;
+            }
             LocTimerDelegate* priorTop = mTimerContainer->getSoonestTimer();
 
             // update soonest timer only if mTimer is actually removed from
             // mTimerContainer AND mTimer is not priorTop.
-            if (priorTop == ((LocHeap*)mTimerContainer)->remove((LocRankable&)*mTimer)) {
+            if (priorTop ==
+                    ((LocIndexedHeap*)mTimerContainer)->remove((LocRankable&)*mTimer)) {
                 // if passing in NULL, we tell updateSoonestTime to update
                 // kernel with the current top timer interval.
                 mTimerContainer->updateSoonestTime(NULL);
@@ -372,6 +423,10 @@ void LocTimerContainer::expire() {
         inline MsgTimerExpire(LocTimerContainer& container) :
             LocMsg(), mTimerContainer(&container) {}
         inline virtual void proc() const {
+            if (mTimerContainer->mWheel) {
+                mTimerContainer->wheelExpire();
+                return;
+            }
             struct timespec now;
             // get time spec of now
             clock_gettime(CLOCK_BOOTTIME, &now);
@@ -397,71 +452,165 @@ void LocTimerContainer::expire() {
 
 LocTimerDelegate* LocTimerContainer::popIfOutRanks(LocTimerDelegate& timer) {
     LocTimerDelegate* poppedNode = NULL;
-    if (mTree && !timer.outRanks(*peek())) {
+    if (peek() && !timer.outRanks(*peek())) {
         poppedNode = (LocTimerDelegate*)(pop());
     }
 
     return poppedNode;
 }
 
-
-/***************************LocTimerPollTask methods***************************/
-
-inline
-LocTimerPollTask::LocTimerPollTask()
-    : mFd(epoll_create(2)), mThread() {
-    // before a next call returens, a thread will be created. The run() method
-    // could already be running in parallel. Also, since each of the objs
-    // creates a thread, the container will make sure that there will be only
-    // one of such obj for our timer implementation.
-    mThread.start("LocTimerPollTask", std::make_shared<TimerRunnable>(mFd));
+// arms timerfd to the start of the given tick, or disarms it if NO_TICK.
+void LocTimerContainer::armWheel(uint64_t tick) {
+    struct itimerspec delay;
+    memset(&delay, 0, sizeof(struct itimerspec));
+    if (NO_TICK == tick) {
+        mPollTask->removePoll(*this);
+    } else {
+        // add poll first, same as updateSoonestTime()
+        mPollTask->addPoll(*this);
+        uint64_t ns = tick * mTickNs;
+        delay.it_value.tv_sec = ns / 1000000000ULL;
+        delay.it_value.tv_nsec = ns % 1000000000ULL;
+    }
+    mArmedTick = tick;
+    timerfd_settime(getTimerFd(), TFD_TIMER_ABSTIME, &delay, NULL);
 }
 
-void LocTimerPollTask::addPoll(LocTimerContainer& timerContainer) {
-    struct epoll_event ev;
-    memset(&ev, 0, sizeof(ev));
-
-    ev.events = EPOLLIN;
-    ev.data.fd = timerContainer.getTimerFd();
-    // it is important that we set this context pointer with the input
-    // timer container this is how we know which container should handle
-    // which expiration.
-    ev.data.ptr = &timerContainer;
+// timer goes into the bucket of the first tick at or after its time out, so
+// it never expires early, but may be late by up to one tick.
+void LocTimerContainer::wheelPush(LocTimerDelegate& timer) {
+    uint64_t tick = (timespecToNs(timer.mFutureTime) + mTickNs - 1) / mTickNs;
+    // ticks up to the cursor have been expired already
+    if (tick <= mWheelCursor) {
+        tick = mWheelCursor + 1;
+    }
+    WheelBucket& bucket = mWheel[tick % WHEEL_SIZE];
+    timer.mWheelTick = tick;
+    timer.mWheelPrev = NULL;
+    timer.mWheelNext = bucket.mHead;
+    if (bucket.mHead) {
+        bucket.mHead->mWheelPrev = &timer;
+    }
+    bucket.mHead = &timer;
+    if (tick < bucket.mMinTick) {
+        bucket.mMinTick = tick;
+    }
+    mWheelCount++;
 
-    epoll_ctl(mFd, EPOLL_CTL_ADD, timerContainer.getTimerFd(), &ev);
+    if (tick < mArmedTick) {
+        armWheel(tick);
+    }
 }
 
-inline
-void LocTimerPollTask::removePoll(LocTimerContainer& timerContainer) {
-    epoll_ctl(mFd, EPOLL_CTL_DEL, timerContainer.getTimerFd(), NULL);
-}
+// timerfd is left armed unless the wheel is empty; an early wake up just
+// finds nothing due and rearms.
+void LocTimerContainer::wheelRemove(LocTimerDelegate& timer) {
+    if (0 == timer.mWheelTick) {
+        // already expired
+        return;
+    }
+    WheelBucket& bucket = mWheel[timer.mWheelTick % WHEEL_SIZE];
+    if (timer.mWheelPrev) {
+        timer.mWheelPrev->mWheelNext = timer.mWheelNext;
+    } else {
+        bucket.mHead = timer.mWheelNext;
+    }
+    if (timer.mWheelNext) {
+        timer.mWheelNext->mWheelPrev = timer.mWheelPrev;
+    }
+    if (!bucket.mHead) {
+        bucket.mMinTick = NO_TICK;
+    }
+    timer.mWheelPrev = timer.mWheelNext = NULL;
+    timer.mWheelTick = 0;
 
-// The polling thread context will call this method. If run() method needs to
-// be repetitvely called, it must return true from the previous call.
-bool TimerRunnable::run() {
-    struct epoll_event ev[2];
+    if (0 == --mWheelCount) {
+        armWheel(NO_TICK);
+    }
+}
 
-    // we have max 2 descriptors to poll from
-    int fds = epoll_wait(mFd, ev, 2, -1);
+// unlinks all the timers due by now from the buckets the cursor passes,
+// then expires them as one batch, and rearms to the soonest tick left.
+void LocTimerContainer::wheelExpire() {
+    struct timespec now;
+    clock_gettime(CLOCK_BOOTTIME, &now);
+    uint64_t nowTick = timespecToNs(now) / mTickNs;
+    LocTimerDelegate* expired = NULL;
+
+    if (nowTick > mWheelCursor) {
+        uint64_t ticks = nowTick - mWheelCursor;
+        if (ticks > WHEEL_SIZE) {
+            ticks = WHEEL_SIZE;
+        }
+        for (uint64_t tick = nowTick - ticks + 1; tick <= nowTick; tick++) {
+            WheelBucket& bucket = mWheel[tick % WHEEL_SIZE];
+            // timers of a later round stay, and the bucket minimum is redone
+            uint64_t minTick = NO_TICK;
+            LocTimerDelegate* timer = bucket.mHead;
+            while (timer) {
+                LocTimerDelegate* next = timer->mWheelNext;
+                if (timer->mWheelTick <= nowTick) {
+                    if (timer->mWheelPrev) {
+                        timer->mWheelPrev->mWheelNext = next;
+                    } else {
+                        bucket.mHead = next;
+                    }
+                    if (next) {
+                        next->mWheelPrev = timer->mWheelPrev;
+                    }
+                    timer->mWheelTick = 0;
+                    timer->mWheelPrev = NULL;
+                    timer->mWheelNext = expired;
+                    expired = timer;
+                    mWheelCount--;
+                } else if (timer->mWheelTick < minTick) {
+                    minTick = timer->mWheelTick;
+                }
+                timer = next;
+            }
+            bucket.mMinTick = minTick;
+        }
+        mWheelCursor = nowTick;
+    }
 
-    // we pretty much want to continually poll until the fd is closed
-    bool rerun = (fds > 0) || (errno == EINTR);
+    // a client callback may start a timer, which goes through the msg
+    // queue, so the wheel is not touched while the batch expires.
+    while (expired) {
+        LocTimerDelegate* timer = expired;
+        expired = timer->mWheelNext;
+        timer->mWheelNext = NULL;
+        // the timer delegate obj will be deleted after the return of this call
+        timer->expire();
+    }
 
-    if (fds > 0) {
-        // we may have 2 events
-        for (int i = 0; i < fds; i++) {
-            // each fd has a context pointer associated with the right timer container
-            LocTimerContainer* container = (LocTimerContainer*)(ev[i].data.ptr);
-            if (container) {
-                container->expire();
-            } else {
-                epoll_ctl(mFd, EPOLL_CTL_DEL, ev[i].data.fd, NULL);
+    uint64_t soonest = NO_TICK;
+    if (mWheelCount > 0) {
+        for (uint32_t i = 0; i < WHEEL_SIZE; i++) {
+            if (mWheel[i].mMinTick < soonest) {
+                soonest = mWheel[i].mMinTick;
             }
         }
     }
+    armWheel(soonest);
+}
 
-    // if rerun is true, we are requesting to be scheduled again
-    return rerun;
+
+/***************************LocTimerPollTask methods***************************/
+
+inline
+LocTimerPollTask::LocTimerPollTask()
+    : mLoop(LocEventLoop::getDefault()) {
+}
+
+void LocTimerPollTask::addPoll(LocTimerContainer& timerContainer) {
+    // it is important that the input timer container is the handler, this
+    // is how we know which container should handle which expiration.
+    mLoop.addFd(timerContainer.getTimerFd(), EPOLLIN, timerContainer);
+}
+
+inline
+void LocTimerPollTask::removePoll(LocTimerContainer& timerContainer) {
+    mLoop.removeFd(timerContainer.getTimerFd());
 }
 
 /***************************LocTimerDelegate methods***************************/
@@ -473,7 +622,10 @@ LocTimerDelegate::LocTimerDelegate(LocTimer& client,
     : mClient(&client),
       mLock(mClient->mLock->share()),
       mFutureTime(futureTime),
-      mContainer(container) {
+      mContainer(container),
+      mWheelPrev(NULL),
+      mWheelNext(NULL),
+      mWheelTick(0) {
     // adding the timer into the container
     mContainer->add(*this);
 }
@@ -566,6 +718,10 @@ bool LocTimer::start(unsigned int timeOutInMs, bool wakeOnExpire) {
     return success;
 }
 
+void LocTimer::setNonWakeupSlack(uint32_t slackMs) {
+    LocTimerContainer::setSlack(slackMs);
+}
+
 bool LocTimer::stop() {
     bool success = false;
     mLock->lock();
@@ -638,6 +794,11 @@ void* loc_timer_start(uint64_t msec, loc_timer_callback cb_func,
     return locTimerWrapper;
 }
 
+void loc_timer_set_slack(uint32_t slack_msec)
+{
+    loc_util::LocTimer::setNonWakeupSlack(slack_msec);
+}
+
 void loc_timer_stop(void*&  handle)
 {
     if (handle) {
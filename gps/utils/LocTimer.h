@@ -67,6 +67,13 @@ public:
     //               false on failure, e.g. timer is not running.
     bool stop();
 
+    // slackMs:      granularity, in ms, by which timers started with
+    //               wakeOnExpire false may expire late, so that their
+    //               expiries coalesce into fewer wakeups. 0 keeps them exact.
+    //               Takes effect only if called before the first such timer
+    //               is started in the process.
+    static void setNonWakeupSlack(uint32_t slackMs);
+
     //  LocTimer client Should implement this method.
     //  This method is used for timeout calling back to client. This method
     //  should be short enough (eg: send a message to your own thread).
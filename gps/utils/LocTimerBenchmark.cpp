@@ -0,0 +1,203 @@
+/* Copyright (c) 2020 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/* Microbenchmark of the LocTimer containers: add / remove / expire throughput
+   of LocIndexedHeap against the LocHeap pointer tree it replaced, and of the
+   LocTimer API itself, with thousands of concurrent timers as with geofence
+   dwell, ODCPI, AGPS and batching all active.
+
+   Usage: loc_timer_benchmark [--benchmark_filter=<regex>] */
+
+#include <LocHeap.h>
+#include <LocTimer.h>
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <random>
+#include <unistd.h>
+#include <vector>
+
+using namespace loc_util;
+
+namespace {
+
+// ranks like LocTimerDelegate, the earliest expiry first
+struct BenchRankable : public LocRankable {
+    uint64_t mExpiry;
+    virtual int ranks(LocRankable& rankable) override {
+        uint64_t other = static_cast<BenchRankable&>(rankable).mExpiry;
+        return (mExpiry < other) ? 1 : ((mExpiry > other) ? -1 : 0);
+    }
+};
+
+// count nodes with distinct expiries in random order, as LocHeap::remove()
+// finds a node by its rank
+void makeNodes(std::vector<BenchRankable>& nodes, size_t count) {
+    nodes.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        nodes[i].mExpiry = i;
+    }
+    std::mt19937 rng(count);
+    std::shuffle(nodes.begin(), nodes.end(), rng);
+}
+
+template <typename Heap>
+void drain(Heap& heap) {
+    while (nullptr != heap.pop()) {}
+}
+
+template <typename Heap>
+void BM_HeapAdd(benchmark::State& state) {
+    std::vector<BenchRankable> nodes;
+    makeNodes(nodes, state.range(0));
+    for (auto _ : state) {
+        Heap heap;
+        for (auto& node : nodes) {
+            heap.push(node);
+        }
+        state.PauseTiming();
+        drain(heap);
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * nodes.size());
+}
+
+// LocTimer::stop() of timers in any order
+template <typename Heap>
+void BM_HeapRemove(benchmark::State& state) {
+    std::vector<BenchRankable> nodes;
+    makeNodes(nodes, state.range(0));
+    std::vector<BenchRankable*> order;
+    for (auto& node : nodes) {
+        order.push_back(&node);
+    }
+    std::shuffle(order.begin(), order.end(), std::mt19937(1));
+    for (auto _ : state) {
+        state.PauseTiming();
+        Heap heap;
+        for (auto& node : nodes) {
+            heap.push(node);
+        }
+        state.ResumeTiming();
+        for (auto node : order) {
+            benchmark::DoNotOptimize(heap.remove(*node));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * nodes.size());
+}
+
+// timers expiring in order, each popped off the top
+template <typename Heap>
+void BM_HeapExpire(benchmark::State& state) {
+    std::vector<BenchRankable> nodes;
+    makeNodes(nodes, state.range(0));
+    for (auto _ : state) {
+        state.PauseTiming();
+        Heap heap;
+        for (auto& node : nodes) {
+            heap.push(node);
+        }
+        state.ResumeTiming();
+        drain(heap);
+    }
+    state.SetItemsProcessed(state.iterations() * nodes.size());
+}
+
+BENCHMARK_TEMPLATE(BM_HeapAdd, LocHeap)->Range(1 << 10, 1 << 14);
+BENCHMARK_TEMPLATE(BM_HeapAdd, LocIndexedHeap)->Range(1 << 10, 1 << 14);
+BENCHMARK_TEMPLATE(BM_HeapRemove, LocHeap)->Range(1 << 10, 1 << 14);
+BENCHMARK_TEMPLATE(BM_HeapRemove, LocIndexedHeap)->Range(1 << 10, 1 << 14);
+BENCHMARK_TEMPLATE(BM_HeapExpire, LocHeap)->Range(1 << 10, 1 << 14);
+BENCHMARK_TEMPLATE(BM_HeapExpire, LocIndexedHeap)->Range(1 << 10, 1 << 14);
+
+class BenchTimer : public LocTimer {
+    std::atomic<uint32_t>& mFired;
+public:
+    inline BenchTimer(std::atomic<uint32_t>& fired) : mFired(fired) {}
+    virtual void timeOutCallback() override { mFired++; }
+};
+
+// start and stop of timers that are far from expiring, through the timer
+// thread of the process wide container
+void BM_LocTimerStartStop(benchmark::State& state) {
+    std::atomic<uint32_t> fired(0);
+    std::vector<BenchTimer*> timers;
+    for (int64_t i = 0; i < state.range(0); i++) {
+        timers.push_back(new BenchTimer(fired));
+    }
+    for (auto _ : state) {
+        uint32_t timeOutMs = 60000;
+        for (auto timer : timers) {
+            timer->start(timeOutMs++, false);
+        }
+        for (auto timer : timers) {
+            timer->stop();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * timers.size());
+    for (auto timer : timers) {
+        delete timer;
+    }
+}
+BENCHMARK(BM_LocTimerStartStop)->Range(1 << 10, 1 << 13)->UseRealTime();
+
+// timers all expiring within a few ms, timed until the last callback
+void BM_LocTimerExpire(benchmark::State& state) {
+    std::atomic<uint32_t> fired(0);
+    std::vector<BenchTimer*> timers;
+    for (int64_t i = 0; i < state.range(0); i++) {
+        timers.push_back(new BenchTimer(fired));
+    }
+    // the first timer brings up the container and its thread
+    timers[0]->start(1, false);
+    while (0 == fired.load()) {
+        usleep(100);
+    }
+    for (auto _ : state) {
+        fired = 0;
+        uint32_t i = 0;
+        for (auto timer : timers) {
+            timer->start(1 + (i++ % 4), false);
+        }
+        while (fired.load() < timers.size()) {
+            usleep(100);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * timers.size());
+    for (auto timer : timers) {
+        delete timer;
+    }
+}
+BENCHMARK(BM_LocTimerExpire)->Range(1 << 10, 1 << 13)->UseRealTime();
+
+} // namespace
+
+BENCHMARK_MAIN();
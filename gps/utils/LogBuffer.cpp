@@ -28,6 +28,17 @@
  */
 
 #include "LogBuffer.h"
+#include <inttypes.h>
+#include <ctype.h>
+#include <algorithm>
+#include <new>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/file.h>
+#include <limits.h>
+#include <sys/stat.h>
 #ifdef USE_GLIB
 #include <execinfo.h>
 #endif
@@ -54,9 +65,12 @@ LogBuffer* LogBuffer::getInstance() {
     return mInstance;
 }
 
-LogBuffer::LogBuffer(): mLogList(TOTAL_LOG_LEVELS),
-        mConfigVec(TOTAL_LOG_LEVELS, ConfigsInLevel(TIME_DEPTH_THRESHOLD_MINIMAL_IN_SEC,
-                    MAXIMUM_NUM_IN_LIST, 0)) {
+static const uint32_t LOG_BUFFER_MAGIC = 0x4C4F4742; // "LOGB"
+static const uint32_t LOG_BUFFER_VERSION = 3;
+
+LogBuffer::LogBuffer(): mConfigVec(TOTAL_LOG_LEVELS,
+                    ConfigsInLevel(TIME_DEPTH_THRESHOLD_MINIMAL_IN_SEC, MAXIMUM_NUM_IN_LIST, 0)),
+        mArena(nullptr), mFileBacked(false), mArenaFd(-1) {
     loc_param_s_type log_buff_config_table[] =
     {
         {"E_LEVEL_TIME_DEPTH",      &mConfigVec[0].mTimeDepthThres,  NULL, 'n'},
@@ -72,40 +86,469 @@ LogBuffer::LogBuffer(): mLogList(TOTAL_LOG_LEVELS),
     };
     loc_read_conf(LOC_PATH_GPS_CONF_STR, log_buff_config_table,
             sizeof(log_buff_config_table)/sizeof(log_buff_config_table[0]));
+    allocArena();
     registerSignalHandler();
 }
 
+// lays out the arena: the ArenaHead, then per level the owner of each unit,
+// i.e. 1 + the first unit of the line it is part of, then the units.
+void LogBuffer::allocArena() {
+    const uint64_t maxLineUnits =
+            (sizeof(RecordHead) + LOGGING_BUFFER_MAX_LEN + UNIT_SIZE - 1) / UNIT_SIZE;
+    uint64_t size = (sizeof(ArenaHead) + UNIT_SIZE - 1) / UNIT_SIZE * UNIT_SIZE;
+    uint64_t unitCount[TOTAL_LOG_LEVELS];
+    for (int i = 0; i < TOTAL_LOG_LEVELS; i++) {
+        // at least room for 2 lines of the max length
+        unitCount[i] = max((uint64_t)mConfigVec[i].mMaxNumThres * UNITS_PER_LINE,
+                           2 * maxLineUnits);
+        size += unitCount[i] * (sizeof(atomic<uint64_t>) + UNIT_SIZE);
+    }
+
+    char* base = mapArena(size);
+    if (nullptr != base) {
+        mFileBacked = true;
+    } else if (nullptr == (base = (char*)calloc(1, size))) {
+        ALOGE("LogBuffer arena of %" PRIu64 " bytes alloc failure", size);
+        return;
+    }
+    ArenaHead* arena = new (base) ArenaHead();
+    arena->mMagic = LOG_BUFFER_MAGIC;
+    arena->mVersion = LOG_BUFFER_VERSION;
+    arena->mUnitSize = UNIT_SIZE;
+    arena->mLevels = TOTAL_LOG_LEVELS;
+    arena->mSize = size;
+    uint64_t offset = (sizeof(ArenaHead) + UNIT_SIZE - 1) / UNIT_SIZE * UNIT_SIZE;
+    for (int i = 0; i < TOTAL_LOG_LEVELS; i++) {
+        LevelHead& level = arena->mLevel[i];
+        level.mUnitCount = unitCount[i];
+        level.mOwnersOffset = offset;
+        offset += unitCount[i] * sizeof(atomic<uint64_t>);
+        level.mUnitsOffset = offset;
+        offset += unitCount[i] * UNIT_SIZE;
+        atomic<uint64_t>* owners = (atomic<uint64_t>*)(base + level.mOwnersOffset);
+        for (uint64_t u = 0; u < unitCount[i]; u++) {
+            new (&owners[u]) atomic<uint64_t>(0);
+        }
+    }
+    mArena = arena;
+}
+
+string LogBuffer::getArenaPath(const char* processName, bool prev) {
+    char name[PATH_MAX];
+    snprintf(name, sizeof(name), LOG_BUFFER_FILE_PATH LOG_BUFFER_ARENA_FILE "%s",
+             processName, prev ? ".prev" : "");
+    return name;
+}
+
+// maps a zeroed LOG_BUFFER_ARENA_FILE of size bytes for this process name,
+// after moving the one left by the previous run aside. The file is locked
+// while mapped; if another live process of the same name holds it, the
+// arena is left to anonymous memory instead.
+char* LogBuffer::mapArena(uint64_t size) {
+    char processName[32] = "unknown";
+    FILE* comm = fopen("/proc/self/comm", "re");
+    if (nullptr != comm) {
+        if (nullptr != fgets(processName, sizeof(processName), comm)) {
+            processName[strcspn(processName, "\n")] = '\0';
+        }
+        fclose(comm);
+    }
+    for (char* c = processName; '\0' != *c; c++) {
+        if (!isalnum((unsigned char)*c) && '-' != *c && '_' != *c && '.' != *c) {
+            *c = '_';
+        }
+    }
+    string path = getArenaPath(processName);
+
+    // the holder of the lock may move the file aside before it is locked
+    // here, so the lock only counts if the file is still the one at path
+    int fd = -1;
+    struct stat st;
+    for (int attempt = 0; attempt < 3 && fd < 0; attempt++) {
+        fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0640);
+        if (fd < 0) {
+            break;
+        }
+        if (0 != flock(fd, LOCK_EX | LOCK_NB)) {
+            ALOGW("LogBuffer %s is in use by another process", path.c_str());
+            close(fd);
+            return nullptr;
+        }
+        struct stat atPath;
+        if (0 != fstat(fd, &st) || 0 != stat(path.c_str(), &atPath) ||
+            st.st_dev != atPath.st_dev || st.st_ino != atPath.st_ino) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    if (fd >= 0 && st.st_size > 0) {
+        // the arena of the previous run, which is over as nobody held it.
+        // The new one is created under a name of this process and takes its
+        // place while it is still locked, so no other process can get either
+        string newPath = path + "." + to_string(getpid());
+        unlink(newPath.c_str());
+        int newFd = open(newPath.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0640);
+        if (newFd >= 0 && 0 == flock(newFd, LOCK_EX | LOCK_NB) &&
+            0 == rename(path.c_str(), getArenaPath(processName, true).c_str()) &&
+            0 == rename(newPath.c_str(), path.c_str())) {
+            close(fd);
+            fd = newFd;
+        } else {
+            ALOGW("LogBuffer failed to replace %s, errno: %d", path.c_str(), errno);
+            if (newFd >= 0) {
+                unlink(newPath.c_str());
+                close(newFd);
+            }
+            close(fd);
+            return nullptr;
+        }
+    }
+    if (fd < 0) {
+        ALOGW("LogBuffer failed to open %s, errno: %d", path.c_str(), errno);
+        return nullptr;
+    }
+    void* base = MAP_FAILED;
+    if (0 == ftruncate(fd, size)) {
+        base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    if (MAP_FAILED == base) {
+        ALOGW("LogBuffer failed to map %s, errno: %d", path.c_str(), errno);
+        unlink(path.c_str());
+        close(fd);
+        return nullptr;
+    }
+    // the mapping stays valid after the fd is closed, which is kept open
+    // for the lock though
+    mArenaFd = fd;
+    return (char*)base;
+}
+
 void LogBuffer::append(string& data, int level, uint64_t timestamp) {
-    lock_guard<mutex> guard(mLock);
-    pair<uint64_t, string> item(timestamp, data);
-    mLogList.append(item, level);
-    mConfigVec[level].mCurrentSize++;
+    append(data.data(), data.length(), level, timestamp);
+}
+
+// copies len bytes in / out of the units of a level at byte offset, which
+// wraps around to the first unit
+static inline void copyToUnits(char* units, uint64_t size, uint64_t offset,
+                               const char* data, size_t len) {
+    offset %= size;
+    size_t first = min((uint64_t)len, size - offset);
+    memcpy(units + offset, data, first);
+    memcpy(units, data + first, len - first);
+}
+static inline void copyFromUnits(const char* units, uint64_t size, uint64_t offset,
+                                 char* data, size_t len) {
+    offset %= size;
+    size_t first = min((uint64_t)len, size - offset);
+    memcpy(data, units + offset, first);
+    memcpy(data + first, units, len - first);
+}
+
+void LogBuffer::append(const char* data, size_t length, int level, uint64_t timestamp,
+                       uint16_t flags) {
+    if (nullptr == mArena || level < 0 || level >= TOTAL_LOG_LEVELS) {
+        return;
+    }
+    LevelHead& lh = mArena->mLevel[level];
+    char* base = (char*)mArena;
+    char* units = base + lh.mUnitsOffset;
+    atomic<uint64_t>* owners = (atomic<uint64_t>*)(base + lh.mOwnersOffset);
+
+    length = min(length, (size_t)LOGGING_BUFFER_MAX_LEN);
+    uint32_t count = (sizeof(RecordHead) + length + UNIT_SIZE - 1) / UNIT_SIZE;
+    uint64_t start = lh.mHead.fetch_add(count, std::memory_order_relaxed);
+    for (uint32_t i = 0; i < count; i++) {
+        owners[(start + i) % lh.mUnitCount].store(start + 1, std::memory_order_relaxed);
+    }
+
+    RecordHead* head = (RecordHead*)(units + (start % lh.mUnitCount) * UNIT_SIZE);
+    head->mVersion.store(2 * start + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    head->mSeq = mArena->mSeq.fetch_add(1, std::memory_order_relaxed);
+    head->mTimestamp = timestamp;
+    head->mLength = length;
+    head->mUnits = count;
+    head->mFlags = flags;
+    copyToUnits(units, lh.mUnitCount * UNIT_SIZE,
+                (start % lh.mUnitCount) * UNIT_SIZE + sizeof(RecordHead), data, length);
+    head->mVersion.store(2 * start + 2, std::memory_order_release);
+}
+
+// Walks the units of the level still in the ring. A line is taken only if
+// it was complete before, and not overwritten while, being copied out.
+void LogBuffer::collect(const ArenaHead* arena, int level, vector<Record>& records) {
+    const LevelHead& lh = arena->mLevel[level];
+    const char* base = (const char*)arena;
+    const char* units = base + lh.mUnitsOffset;
+    const atomic<uint64_t>* owners = (const atomic<uint64_t>*)(base + lh.mOwnersOffset);
+    const uint64_t n = lh.mUnitCount;
+
+    uint64_t end = lh.mHead.load(std::memory_order_acquire);
+    uint64_t u = max(lh.mFloor.load(std::memory_order_relaxed), (end > n) ? (end - n) : 0);
+    while (u < end) {
+        if (owners[u % n].load(std::memory_order_acquire) != u + 1) {
+            u++;
+            continue;
+        }
+        const RecordHead* head = (const RecordHead*)(units + (u % n) * UNIT_SIZE);
+        uint64_t version = head->mVersion.load(std::memory_order_acquire);
+        uint32_t count = head->mUnits;
+        uint32_t length = head->mLength;
+        if (version != 2 * u + 2 || 0 == count || count > n ||
+            length > LOGGING_BUFFER_MAX_LEN) {
+            u++;
+            continue;
+        }
+        Record record;
+        record.mSeq = head->mSeq;
+        record.mTimestamp = head->mTimestamp;
+        record.mLevel = level;
+        record.mFlags = head->mFlags;
+        record.mData.resize(length);
+        copyFromUnits(units, n * UNIT_SIZE, (u % n) * UNIT_SIZE + sizeof(RecordHead),
+                      &record.mData[0], length);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (head->mVersion.load(std::memory_order_relaxed) == version &&
+            lh.mHead.load(std::memory_order_relaxed) <= u + n) {
+            records.push_back(std::move(record));
+            u += count;
+        } else {
+            u++;
+        }
+    }
+}
+
+// same thresholds as lines used to be evicted by, relative to the newest
+void LogBuffer::trim(int level, vector<Record>& records, size_t first) {
+    size_t total = records.size() - first;
+    if (total > 0) {
+        uint64_t newest = records.back().mTimestamp;
+        size_t keepFrom = first + ((total > mConfigVec[level].mMaxNumThres) ?
+                                   (total - mConfigVec[level].mMaxNumThres) : 0);
+        while (keepFrom < records.size() &&
+               newest - records[keepFrom].mTimestamp > mConfigVec[level].mTimeDepthThres) {
+            keepFrom++;
+        }
+        records.erase(records.begin() + first, records.begin() + keepFrom);
+    }
+}
+
+bool LogBuffer::decode(const void* arena, size_t size, vector<Record>& records) {
+    const ArenaHead* head = (const ArenaHead*)arena;
+    if (size < sizeof(ArenaHead) || LOG_BUFFER_MAGIC != head->mMagic ||
+        LOG_BUFFER_VERSION != head->mVersion || UNIT_SIZE != head->mUnitSize ||
+        TOTAL_LOG_LEVELS != head->mLevels || head->mSize > size) {
+        return false;
+    }
+    for (int i = 0; i < TOTAL_LOG_LEVELS; i++) {
+        const LevelHead& lh = head->mLevel[i];
+        if (0 == lh.mUnitCount || lh.mUnitCount > size / UNIT_SIZE ||
+            lh.mOwnersOffset > size - lh.mUnitCount * sizeof(atomic<uint64_t>) ||
+            lh.mUnitsOffset > size - lh.mUnitCount * UNIT_SIZE) {
+            return false;
+        }
+    }
+    for (int i = 0; i < TOTAL_LOG_LEVELS; i++) {
+        collect(head, i, records);
+    }
+    sort(records.begin(), records.end(), [](const Record& a, const Record& b) {
+        return a.mSeq < b.mSeq;
+    });
+    return true;
+}
+
+// the snprintf conversion of one argument, with the length modifier in spec
+// replaced by the one of the type it was recorded as
+static void formatArg(string& out, string spec, char conv, int stars[], int starCount,
+                      uint8_t type, const char* val, uint16_t len) {
+    bool intConv = nullptr != strchr("diouxXc", conv);
+    bool doubleConv = nullptr != strchr("fFeEgGaA", conv);
+    if (!((intConv && (LOC_LOG_ARG_INT == type || LOC_LOG_ARG_INT64 == type)) ||
+          (doubleConv && LOC_LOG_ARG_DOUBLE == type) ||
+          ('s' == conv && LOC_LOG_ARG_STR == type) ||
+          ('p' == conv && LOC_LOG_ARG_PTR == type))) {
+        out += "<?>";
+        return;
+    }
+    while (!spec.empty() && nullptr != strchr("hlLqjzt", spec.back()) &&
+           !(LOC_LOG_ARG_INT == type && 'h' == spec.back())) {
+        spec.pop_back();
+    }
+    if (LOC_LOG_ARG_INT64 == type) {
+        spec += "ll";
+    }
+    spec += conv;
+
+    char buf[LOGGING_BUFFER_MAX_LEN];
+    const char* fmt = spec.c_str();
+    int32_t i32;
+    int64_t i64;
+    double d;
+    uint64_t p64;
+    const void* p;
+    string str;
+    switch (type) {
+    case LOC_LOG_ARG_INT:
+        memcpy(&i32, val, sizeof(i32));
+        if (0 == starCount) snprintf(buf, sizeof(buf), fmt, (int)i32);
+        else if (1 == starCount) snprintf(buf, sizeof(buf), fmt, stars[0], (int)i32);
+        else snprintf(buf, sizeof(buf), fmt, stars[0], stars[1], (int)i32);
+        break;
+    case LOC_LOG_ARG_INT64:
+        memcpy(&i64, val, sizeof(i64));
+        if (0 == starCount) snprintf(buf, sizeof(buf), fmt, (long long)i64);
+        else if (1 == starCount) snprintf(buf, sizeof(buf), fmt, stars[0], (long long)i64);
+        else snprintf(buf, sizeof(buf), fmt, stars[0], stars[1], (long long)i64);
+        break;
+    case LOC_LOG_ARG_DOUBLE:
+        memcpy(&d, val, sizeof(d));
+        if (0 == starCount) snprintf(buf, sizeof(buf), fmt, d);
+        else if (1 == starCount) snprintf(buf, sizeof(buf), fmt, stars[0], d);
+        else snprintf(buf, sizeof(buf), fmt, stars[0], stars[1], d);
+        break;
+    case LOC_LOG_ARG_PTR:
+        memcpy(&p64, val, sizeof(p64));
+        p = (const void*)(uintptr_t)p64;
+        if (0 == starCount) snprintf(buf, sizeof(buf), fmt, p);
+        else if (1 == starCount) snprintf(buf, sizeof(buf), fmt, stars[0], p);
+        else snprintf(buf, sizeof(buf), fmt, stars[0], stars[1], p);
+        break;
+    default:
+        str.assign(val, len);
+        if (0 == starCount) snprintf(buf, sizeof(buf), fmt, str.c_str());
+        else if (1 == starCount) snprintf(buf, sizeof(buf), fmt, stars[0], str.c_str());
+        else snprintf(buf, sizeof(buf), fmt, stars[0], stars[1], str.c_str());
+        break;
+    }
+    out += buf;
+}
+
+// Formats a record of log_buffer_insert_args() into the same text as
+// INSERT_BUFFER would have, walking the conversions of the format string
+// and taking the recorded arguments in order.
+string LogBuffer::formatBinary(const string& data) {
+    LocLogBinHead head;
+    if (data.size() < sizeof(head)) {
+        return "<bad binary record>";
+    }
+    memcpy(&head, data.data(), sizeof(head));
+    if (data.size() - sizeof(head) < (size_t)head.mTagLen + head.mFormatLen) {
+        return "<bad binary record>";
+    }
+    string tag(data.data() + sizeof(head), head.mTagLen);
+    string format(data.data() + sizeof(head) + head.mTagLen, head.mFormatLen);
+    const char* arg = data.data() + sizeof(head) + head.mTagLen + head.mFormatLen;
+    const char* end = data.data() + data.size();
+    // takes the next argument, type 0 if there is none left
+    auto next = [&](const char*& val, uint16_t& len) -> uint8_t {
+        if (arg >= end) {
+            return 0;
+        }
+        uint8_t type = *arg++;
+        switch (type) {
+        case LOC_LOG_ARG_INT: len = sizeof(int32_t); break;
+        case LOC_LOG_ARG_INT64: len = sizeof(int64_t); break;
+        case LOC_LOG_ARG_DOUBLE: len = sizeof(double); break;
+        case LOC_LOG_ARG_PTR: len = sizeof(uint64_t); break;
+        case LOC_LOG_ARG_STR:
+            if (end - arg < (ptrdiff_t)sizeof(len)) {
+                arg = end;
+                return 0;
+            }
+            memcpy(&len, arg, sizeof(len));
+            arg += sizeof(len);
+            break;
+        default: arg = end; return 0;
+        }
+        if (end - arg < len) {
+            arg = end;
+            return 0;
+        }
+        val = arg;
+        arg += len;
+        return type;
+    };
 
-    while ((timestamp - mLogList.front(level).first) > mConfigVec[level].mTimeDepthThres ||
-            mConfigVec[level].mCurrentSize > mConfigVec[level].mMaxNumThres) {
-        mLogList.pop(level);
-        mConfigVec[level].mCurrentSize--;
+    char prefix[96];
+    int hh = head.mSec/3600%24;
+    int mm = (head.mSec%3600)/60;
+    int ss = head.mSec%60;
+    snprintf(prefix, sizeof(prefix), "%02d:%02d:%02d.%06d %d %ld %s :", hh, mm, ss,
+             head.mUsec, head.mPid, (long)head.mTid, tag.c_str());
+    string out(prefix);
+    for (const char* f = format.c_str(); '\0' != *f; f++) {
+        if ('%' != *f) {
+            out += *f;
+            continue;
+        }
+        if ('%' == f[1]) {
+            out += '%';
+            f++;
+            continue;
+        }
+        // flags, width, precision and length up to the conversion
+        const char* c = f + 1;
+        while ('\0' != *c && nullptr != strchr("-+ #0123456789.*hlLqjzt", *c)) {
+            c++;
+        }
+        if ('\0' == *c) {
+            out += f;
+            break;
+        }
+        string spec(f, c - f);
+        int stars[2] = {0, 0};
+        int starCount = 0;
+        bool ok = true;
+        for (char sc : spec) {
+            const char* val;
+            uint16_t len;
+            if ('*' == sc) {
+                if (starCount < 2 && LOC_LOG_ARG_INT == next(val, len)) {
+                    memcpy(&stars[starCount++], val, sizeof(int32_t));
+                } else {
+                    ok = false;
+                }
+            }
+        }
+        const char* val = nullptr;
+        uint16_t len = 0;
+        uint8_t type = next(val, len);
+        if (ok && 0 != type && 'n' != *c) {
+            formatArg(out, spec, *c, stars, starCount, type, val, len);
+        } else {
+            out += "<?>";
+        }
+        f = c;
     }
+    out += '\n';
+    return out;
 }
 
 //Dump the log buffer of specific level, level = -1 to dump all the levels in log buffer.
 void LogBuffer::dump(std::function<void(stringstream&)> log, int level) {
-    lock_guard<mutex> guard(mLock);
-    list<pair<pair<uint64_t, string>, int>> li;
-    if (-1 == level) {
-        li = mLogList.dump();
-    } else {
-        li = mLogList.dump(level);
+    vector<Record> li;
+    if (nullptr != mArena) {
+        for (int i = 0; i < TOTAL_LOG_LEVELS; i++) {
+            if (-1 == level || i == level) {
+                size_t first = li.size();
+                collect(mArena, i, li);
+                trim(i, li, first);
+            }
+        }
+        // merge the levels into the order the lines were appended
+        sort(li.begin(), li.end(), [](const Record& a, const Record& b) {
+            return a.mSeq < b.mSeq;
+        });
     }
     ALOGE("Begining of dump, buffer size: %d", (int)li.size());
     stringstream ln;
     ln << "dump log buffer, level[" << level << "]" << ", buffer size: " << li.size() << endl;
     log(ln);
-    for_each (li.begin(), li.end(), [&, this](const pair<pair<uint64_t, string>, int> &item){
+    for_each (li.begin(), li.end(), [&, this](const Record &item){
         stringstream line;
-        line << "["<<item.first.first << "] ";
-        line << "Level " << mLevelMap[item.second] << ": ";
-        line << item.first.second << endl;
+        line << "["<<item.mTimestamp << "] ";
+        line << "Level " << mLevelMap[item.mLevel] << ": ";
+        line << ((item.mFlags & FLAG_BINARY) ? formatBinary(item.mData) : item.mData) << endl;
         if (log != nullptr) {
             log(line);
         }
@@ -130,7 +573,12 @@ void LogBuffer::dumpToLogFile(string filePath) {
 }
 
 void LogBuffer::flush() {
-    mLogList.flush();
+    if (nullptr != mArena) {
+        for (int i = 0; i < TOTAL_LOG_LEVELS; i++) {
+            LevelHead& lh = mArena->mLevel[i];
+            lh.mFloor.store(lh.mHead.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+    }
 }
 
 void LogBuffer::registerSignalHandler() {
@@ -167,6 +615,13 @@ void LogBuffer::signalHandler(const int code, siginfo_t *const si, void *const s
         }
     }
 #endif
+    //With the arena mapped to a file the lines are already on disk, nothing
+    //to format or write unless a dump is asked for explicitly
+    if (mInstance->mFileBacked && code != SIGUSR1) {
+        mOriSigAction[code].sa_sigaction(code, si, sc);
+        return;
+    }
+
     //Dump the log buffer to adb logcat
     mInstance->dumpToAdbLogcat();
 
@@ -30,7 +30,6 @@
 #ifndef LOG_BUFFER_H
 #define LOG_BUFFER_H
 
-#include "SkipList.h"
 #include "log_util.h"
 #include <loc_cfg.h>
 #include <loc_pla.h>
@@ -38,18 +37,25 @@
 #include <sstream>
 #include <ostream>
 #include <fstream>
+#include <vector>
+#include <atomic>
 #include <time.h>
 #include <mutex>
 #include <signal.h>
 #include <thread>
 #include <functional>
 
+using namespace std;
+
 //default error level time depth threshold,
 #define TIME_DEPTH_THRESHOLD_MINIMAL_IN_SEC 60
 //default maximum log buffer size
 #define MAXIMUM_NUM_IN_LIST 50
 //file path of dumped log buffer
 #define LOG_BUFFER_FILE_PATH "/data/vendor/location/"
+//file under LOG_BUFFER_FILE_PATH the log buffer arena is mapped to, one per
+//process name (%s), the one of the previous run is kept with a ".prev" suffix
+#define LOG_BUFFER_ARENA_FILE "gpslog.%s.buf"
 
 namespace loc_util {
 
@@ -63,28 +69,102 @@ public:
         mTimeDepthThres(time), mMaxNumThres(num), mCurrentSize(size) {}
 };
 
+// The log lines are kept in one arena allocated up front, with a circular
+// region of fixed size units per level, sized from the level's
+// mMaxNumThres. A line takes as many consecutive units as it needs, claimed
+// with a single atomic add, so appending threads neither lock nor allocate.
+// Each line carries a global sequence number, by which the levels are
+// merged back into one timeline on dump.
+// The arena is a shared mapping of LOG_BUFFER_ARENA_FILE when that can be
+// created, so on a fatal signal the lines are already on disk and only need
+// decoding offline, see decode().
 class LogBuffer {
+public:
+    static const uint32_t UNIT_SIZE = 128;
+    // units budgeted per line, i.e. lines are expected to average 256 bytes
+    static const uint32_t UNITS_PER_LINE = 2;
+
+    // head of a line, at the start of its first unit
+    struct RecordHead {
+        // 2 * start + 1 while being written, 2 * start + 2 once complete,
+        // start being the index of the first unit in the level
+        atomic<uint64_t> mVersion;
+        uint64_t mSeq;
+        uint64_t mTimestamp;
+        uint32_t mLength;
+        uint16_t mUnits;
+        uint16_t mFlags;
+    };
+    struct LevelHead {
+        // offsets from the arena start
+        uint64_t mUnitsOffset;
+        uint64_t mOwnersOffset;
+        uint64_t mUnitCount;
+        // units claimed so far, monotonic
+        atomic<uint64_t> mHead;
+        // units before this are flushed
+        atomic<uint64_t> mFloor;
+    };
+    struct ArenaHead {
+        uint32_t mMagic;
+        uint32_t mVersion;
+        uint32_t mUnitSize;
+        uint32_t mLevels;
+        uint64_t mSize;
+        atomic<uint64_t> mSeq;
+        LevelHead mLevel[TOTAL_LOG_LEVELS];
+    };
+    // the line is a binary record of log_buffer_insert_args()
+    static const uint16_t FLAG_BINARY = 1;
+    struct Record {
+        uint64_t mSeq;
+        uint64_t mTimestamp;
+        int mLevel;
+        uint16_t mFlags;
+        string mData;
+    };
+
 private:
     static LogBuffer* mInstance;
     static struct sigaction mOriSigAction[NSIG];
     static struct sigaction mNewSigAction;
     static mutex sLock;
 
-    SkipList<pair<uint64_t, string>> mLogList;
     vector<ConfigsInLevel> mConfigVec;
-    mutex mLock;
+    ArenaHead* mArena;
+    bool mFileBacked;
+    // holds the lock on the arena file for the life of the process
+    int mArenaFd;
 
     const vector<string> mLevelMap {"E", "W", "I", "D", "V"};
 
 public:
     static LogBuffer* getInstance();
     void append(string& data, int level, uint64_t timestamp);
+    void append(const char* data, size_t length, int level, uint64_t timestamp,
+                uint16_t flags = 0);
+    // formats a binary record, in any process as it carries its strings
+    static string formatBinary(const string& data);
     void dump(std::function<void(stringstream&)> log, int level = -1);
     void dumpToAdbLogcat();
     void dumpToLogFile(string filePath);
     void flush();
+    // decodes the lines of all levels in a copy or mapping of the arena,
+    // e.g. read from LOG_BUFFER_ARENA_FILE, in the order they were appended
+    static bool decode(const void* arena, size_t size, vector<Record>& records);
 private:
     LogBuffer();
+    void allocArena();
+    char* mapArena(uint64_t size);
+public:
+    // path of the arena file of a process name, of its previous run if prev
+    static string getArenaPath(const char* processName, bool prev = false);
+private:
+    // appends the complete lines of the level in the arena to records
+    static void collect(const ArenaHead* arena, int level, vector<Record>& records);
+    // drops the lines of the level from records[first] on that are beyond
+    // its thresholds
+    void trim(int level, vector<Record>& records, size_t first);
     void registerSignalHandler();
     static void signalHandler(const int code, siginfo_t *const si, void *const sc);
 
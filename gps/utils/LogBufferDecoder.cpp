@@ -0,0 +1,86 @@
+/* Copyright (c) 2019 - 2020 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/* Offline decoder of the LogBuffer arena file, prints the lines of all the
+   levels in the order they were logged, in the format of LogBuffer::dump.
+
+   Usage: gps_logbuf_decoder <arena file | process name>, a process name
+   decodes the arena of its previous run, LOG_BUFFER_ARENA_FILE ".prev" */
+
+#include "LogBuffer.h"
+#include <inttypes.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace loc_util;
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <arena file | process name>\n", argv[0]);
+        return 1;
+    }
+    string arenaPath = (nullptr != strchr(argv[1], '/')) ? string(argv[1]) :
+            LogBuffer::getArenaPath(argv[1], true);
+    const char* path = arenaPath.c_str();
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd < 0 || 0 != fstat(fd, &st)) {
+        fprintf(stderr, "failed to open %s: %s\n", path, strerror(errno));
+        return 1;
+    }
+    void* arena = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (MAP_FAILED == arena) {
+        fprintf(stderr, "failed to map %s: %s\n", path, strerror(errno));
+        return 1;
+    }
+
+    vector<LogBuffer::Record> records;
+    if (!LogBuffer::decode(arena, st.st_size, records)) {
+        fprintf(stderr, "%s is not a log buffer arena\n", path);
+        munmap(arena, st.st_size);
+        return 1;
+    }
+    static const char* levels[TOTAL_LOG_LEVELS] = {"E", "W", "I", "D", "V"};
+    printf("dump log buffer, level[-1], buffer size: %zu\n", records.size());
+    for (auto& record : records) {
+        if (record.mFlags & LogBuffer::FLAG_BINARY) {
+            printf("[%" PRIu64 "] Level %s: %s\n", record.mTimestamp, levels[record.mLevel],
+                   LogBuffer::formatBinary(record.mData).c_str());
+        } else {
+            printf("[%" PRIu64 "] Level %s: %s\n", record.mTimestamp, levels[record.mLevel],
+                   record.mData.c_str());
+        }
+    }
+    munmap(arena, st.st_size);
+    return 0;
+}
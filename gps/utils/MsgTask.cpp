@@ -30,6 +30,15 @@
 #define LOG_TAG "LocSvc_MsgTask"
 
 #include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <inttypes.h>
+#include <atomic>
+#include <vector>
+#include <string>
+#include <algorithm>
 #include <MsgTask.h>
 #include <msg_q.h>
 #include <log_util.h>
@@ -38,10 +47,319 @@
 
 namespace loc_util {
 
+// Fixed set of slots big enough for a TaskMsg, handed out through a lock
+// free free list. Any number of senders take slots, the MsgTask thread
+// gives them back. The list head carries a tag next to the slot index to
+// rule out ABA between concurrent takers.
+class LocTaskMsgPool {
+public:
+    static const uint32_t SLOT_COUNT = 32;
+
+    // prefixed to every TaskMsg allocation; mPool is null for heap fallbacks
+    struct alignas(std::max_align_t) SlotHeader {
+        LocTaskMsgPool* mPool;
+        uint32_t mIndex;
+    };
+
+    LocTaskMsgPool(size_t msgSize);
+    ~LocTaskMsgPool();
+    SlotHeader* get();
+    void put(SlotHeader* slot);
+
+private:
+    inline SlotHeader* slotAt(uint32_t index) const {
+        return (SlotHeader*)(mSlots + index * mSlotSize);
+    }
+    size_t mSlotSize;
+    unsigned char* mSlots;
+    std::atomic<uint32_t> mNext[SLOT_COUNT];
+    // high 32 bits: tag, low 32 bits: index + 1 of the first free slot, 0 if none
+    std::atomic<uint64_t> mFreeHead;
+};
+
+LocTaskMsgPool::LocTaskMsgPool(size_t msgSize) :
+    mSlotSize((sizeof(SlotHeader) + msgSize + alignof(std::max_align_t) - 1) &
+              ~(alignof(std::max_align_t) - 1)),
+    mSlots((unsigned char*)::operator new(mSlotSize * SLOT_COUNT)),
+    mFreeHead(SLOT_COUNT > 0 ? 1 : 0) {
+    for (uint32_t i = 0; i < SLOT_COUNT; i++) {
+        SlotHeader* slot = slotAt(i);
+        slot->mPool = this;
+        slot->mIndex = i;
+        mNext[i].store(i + 1 < SLOT_COUNT ? i + 2 : 0, std::memory_order_relaxed);
+    }
+}
+
+LocTaskMsgPool::~LocTaskMsgPool() {
+    ::operator delete(mSlots);
+}
+
+LocTaskMsgPool::SlotHeader* LocTaskMsgPool::get() {
+    uint64_t head = mFreeHead.load(std::memory_order_acquire);
+    uint64_t newHead;
+    uint32_t index;
+    do {
+        index = (uint32_t)head;
+        if (0 == index) {
+            return nullptr;
+        }
+        newHead = (((head >> 32) + 1) << 32) |
+                mNext[index - 1].load(std::memory_order_relaxed);
+    } while (!mFreeHead.compare_exchange_weak(head, newHead, std::memory_order_acq_rel,
+                                              std::memory_order_acquire));
+    return slotAt(index - 1);
+}
+
+void LocTaskMsgPool::put(SlotHeader* slot) {
+    uint64_t head = mFreeHead.load(std::memory_order_relaxed);
+    uint64_t newHead;
+    do {
+        mNext[slot->mIndex].store((uint32_t)head, std::memory_order_relaxed);
+        newHead = (((head >> 32) + 1) << 32) | (slot->mIndex + 1);
+    } while (!mFreeHead.compare_exchange_weak(head, newHead, std::memory_order_release,
+                                              std::memory_order_relaxed));
+}
+
+// LocMsg carrying a LocTask. It is created in a pool slot and, being a
+// LocMsg, deleted by MTRunnable / msg_q_flush like any other msg; the class
+// specific operator delete then returns the slot to its pool.
+struct TaskMsg : public LocMsg {
+    LocTask mTask;
+    inline TaskMsg(LocTask&& task) : mTask(std::move(task)) {}
+    ~TaskMsg() = default;
+    inline virtual void proc() const override { mTask(); }
+
+    static void* operator new(size_t size, LocTaskMsgPool* pool) {
+        typedef LocTaskMsgPool::SlotHeader SlotHeader;
+        SlotHeader* slot = (nullptr != pool) ? pool->get() : nullptr;
+        if (nullptr == slot) {
+            slot = (SlotHeader*)::operator new(sizeof(SlotHeader) + size);
+            slot->mPool = nullptr;
+        }
+        return slot + 1;
+    }
+    static void operator delete(void* p) {
+        typedef LocTaskMsgPool::SlotHeader SlotHeader;
+        SlotHeader* slot = (SlotHeader*)p - 1;
+        if (nullptr != slot->mPool) {
+            slot->mPool->put(slot);
+        } else {
+            ::operator delete(slot);
+        }
+    }
+    static void operator delete(void* p, LocTaskMsgPool*) {
+        operator delete(p);
+    }
+};
+
+// Written by the MsgTask thread only, read by anyone through
+// MsgTask::getLaneStats().
+class LocMsgLaneCounters {
+public:
+    struct Counters {
+        std::atomic<uint32_t> mDepth;
+        std::atomic<uint32_t> mMaxDepth;
+        std::atomic<uint64_t> mProcessed;
+        std::atomic<uint64_t> mCoalesced;
+    };
+    Counters mLanes[LOC_MSG_LANE_MAX];
+
+    inline LocMsgLaneCounters() {
+        for (auto& lane : mLanes) {
+            lane.mDepth.store(0, std::memory_order_relaxed);
+            lane.mMaxDepth.store(0, std::memory_order_relaxed);
+            lane.mProcessed.store(0, std::memory_order_relaxed);
+            lane.mCoalesced.store(0, std::memory_order_relaxed);
+        }
+    }
+};
+
+// FIFO of the msgs already taken off the msg_q, one per LocMsgLane. Owned
+// by the MsgTask thread, so none of it needs locking. The backing array
+// only grows, to the deepest backlog seen.
+class LocMsgLaneQueue {
+    struct Entry {
+        LocMsg* mMsg;
+        uint64_t mKey;
+    };
+    std::vector<Entry> mEntries;
+    size_t mHead;
+    size_t mCount;
+public:
+    inline LocMsgLaneQueue() : mEntries(16), mHead(0), mCount(0) {}
+    inline ~LocMsgLaneQueue() {
+        while (mCount > 0) {
+            delete pop();
+        }
+    }
+    inline bool empty() const { return 0 == mCount; }
+    inline size_t size() const { return mCount; }
+    // returns true if msg superseded a queued one
+    bool push(LocMsg* msg, uint64_t key) {
+        if (0 != key) {
+            for (size_t i = 0; i < mCount; i++) {
+                Entry& e = mEntries[(mHead + i) % mEntries.size()];
+                if (e.mKey == key) {
+                    delete e.mMsg;
+                    e.mMsg = msg;
+                    return true;
+                }
+            }
+        }
+        if (mCount == mEntries.size()) {
+            std::vector<Entry> entries(mEntries.size() * 2);
+            for (size_t i = 0; i < mCount; i++) {
+                entries[i] = mEntries[(mHead + i) % mEntries.size()];
+            }
+            mEntries.swap(entries);
+            mHead = 0;
+        }
+        mEntries[(mHead + mCount) % mEntries.size()] = {msg, key};
+        mCount++;
+        return false;
+    }
+    inline LocMsg* pop() {
+        LocMsg* msg = mEntries[mHead].mMsg;
+        mHead = (mHead + 1) % mEntries.size();
+        mCount--;
+        return msg;
+    }
+};
+
+static inline uint64_t getMonotonicNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// Queue wait and proc() time of every msg, as log2 microsecond histograms
+// plus a ring of the last TRACE_SIZE msgs. Only the MsgTask thread writes;
+// readers go through relaxed atomics for the histograms and a per record
+// sequence number (odd while the record is being written) for the trace.
+class LocMsgTaskProfile {
+public:
+    // bucket 0: < 1us, bucket n: [2^(n-1), 2^n) us, the last one open ended
+    static const int BUCKETS = 24;
+    static const uint32_t TRACE_SIZE = 1024;
+    // proc() longer than this is logged along with the msg's log()
+    static const uint32_t SLOW_PROC_US = 100000;
+
+    struct Histogram {
+        std::atomic<uint64_t> mBuckets[BUCKETS];
+        std::atomic<uint32_t> mMaxUs;
+    };
+    std::atomic<uint64_t> mCount;
+    Histogram mWait;
+    Histogram mProc;
+
+    inline LocMsgTaskProfile() : mCount(0), mTraceNext(0) {
+        for (Histogram* h : {&mWait, &mProc}) {
+            for (auto& b : h->mBuckets) {
+                b.store(0, std::memory_order_relaxed);
+            }
+            h->mMaxUs.store(0, std::memory_order_relaxed);
+        }
+        for (auto& t : mTrace) {
+            t.mSeq.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    void record(const LocMsg* msg, LocMsgLane lane, uint64_t startNs, uint64_t endNs);
+    uint32_t snapshotTrace(std::vector<LocMsgTraceRecord>& out) const;
+
+private:
+    struct TraceEntry {
+        std::atomic<uint32_t> mSeq;
+        LocMsgTraceRecord mRecord;
+    };
+    TraceEntry mTrace[TRACE_SIZE];
+    uint32_t mTraceNext;
+
+    static inline void add(Histogram& h, uint32_t us) {
+        int bucket = (0 == us) ? 0 : 32 - __builtin_clz(us);
+        if (bucket >= BUCKETS) {
+            bucket = BUCKETS - 1;
+        }
+        h.mBuckets[bucket].fetch_add(1, std::memory_order_relaxed);
+        if (us > h.mMaxUs.load(std::memory_order_relaxed)) {
+            h.mMaxUs.store(us, std::memory_order_relaxed);
+        }
+    }
+    static inline uint32_t toUs(uint64_t ns) {
+        uint64_t us = ns / 1000;
+        return (us > UINT32_MAX) ? UINT32_MAX : (uint32_t)us;
+    }
+};
+
+void LocMsgTaskProfile::record(const LocMsg* msg, LocMsgLane lane,
+                               uint64_t startNs, uint64_t endNs) {
+    uint32_t waitUs = toUs(startNs > msg->mSentTimeNs ? startNs - msg->mSentTimeNs : 0);
+    uint32_t procUs = toUs(endNs - startNs);
+    add(mWait, waitUs);
+    add(mProc, procUs);
+    mCount.fetch_add(1, std::memory_order_relaxed);
+
+    TraceEntry& t = mTrace[mTraceNext];
+    uint32_t seq = t.mSeq.load(std::memory_order_relaxed);
+    t.mSeq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    t.mRecord.mSentTimeNs = msg->mSentTimeNs;
+    t.mRecord.mWaitUs = waitUs;
+    t.mRecord.mProcUs = procUs;
+    const void* vptr = nullptr;
+    memcpy(&vptr, msg, sizeof(vptr));
+    t.mRecord.mTypeId = (uint64_t)(uintptr_t)vptr;
+    t.mRecord.mLane = lane;
+    t.mRecord.mReserved = 0;
+    t.mSeq.store(seq + 2, std::memory_order_release);
+    mTraceNext = (mTraceNext + 1) % TRACE_SIZE;
+
+    if (procUs > SLOW_PROC_US) {
+        LOC_LOGw("msg %p took %u us in proc() after %u us in queue",
+                 vptr, procUs, waitUs);
+        msg->log();
+    }
+}
+
+uint32_t LocMsgTaskProfile::snapshotTrace(std::vector<LocMsgTraceRecord>& out) const {
+    out.clear();
+    out.reserve(TRACE_SIZE);
+    for (uint32_t i = 0; i < TRACE_SIZE; i++) {
+        const TraceEntry& t = mTrace[i];
+        uint32_t seq = t.mSeq.load(std::memory_order_acquire);
+        if (0 == seq || (seq & 1)) {
+            continue;
+        }
+        LocMsgTraceRecord record = t.mRecord;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (seq == t.mSeq.load(std::memory_order_relaxed)) {
+            out.push_back(record);
+        }
+    }
+    std::sort(out.begin(), out.end(),
+              [](const LocMsgTraceRecord& a, const LocMsgTraceRecord& b) {
+                  return a.mSentTimeNs < b.mSentTimeNs;
+              });
+    return out.size();
+}
+
 class MTRunnable : public LocRunnable {
     const void* mQ;
+    // msgs still in mQ may point back into the pool
+    shared_ptr<LocTaskMsgPool> mTaskMsgPool;
+    shared_ptr<LocMsgLaneCounters> mLaneCounters;
+    shared_ptr<LocMsgTaskProfile> mProfile;
+    LocMsgLaneQueue mLanes[LOC_MSG_LANE_MAX];
+    size_t mStaged;
+
+    void stage(LocMsg* msg);
+    LocMsg* next(LocMsgLane& lane);
 public:
-    inline MTRunnable(const void* q) : mQ(q) {}
+    inline MTRunnable(const void* q, const shared_ptr<LocTaskMsgPool>& pool,
+                      const shared_ptr<LocMsgLaneCounters>& laneCounters,
+                      const shared_ptr<LocMsgTaskProfile>& profile) :
+            mQ(q), mTaskMsgPool(pool), mLaneCounters(laneCounters), mProfile(profile),
+            mStaged(0) {}
     virtual ~MTRunnable();
     // Overrides of LocRunnable methods
     // This method will be repeated called until it returns false; or
@@ -60,13 +378,18 @@ static void LocMsgDestroy(void* msg) {
     delete (LocMsg*)msg;
 }
 
-MsgTask::MsgTask(const char* threadName) :
-    mQ(msg_q_init2()), mThread() {
-    mThread.start(threadName, std::make_shared<MTRunnable>(mQ));
+MsgTask::MsgTask(const char* threadName, uint32_t ringSize) :
+    mQ(0 == ringSize ? msg_q_init2() : msg_q_init2_ring(ringSize)),
+    mTaskMsgPool(std::make_shared<LocTaskMsgPool>(sizeof(TaskMsg))),
+    mLaneCounters(std::make_shared<LocMsgLaneCounters>()),
+    mProfile(std::make_shared<LocMsgTaskProfile>()), mThread() {
+    mThread.start(threadName,
+                  std::make_shared<MTRunnable>(mQ, mTaskMsgPool, mLaneCounters, mProfile));
 }
 
 void MsgTask::sendMsg(const LocMsg* msg) const {
     if (msg && this) {
+        msg->mSentTimeNs = loc_logger.MSG_TASK_PROFILING_ENABLE ? getMonotonicNs() : 0;
         msg_q_snd((void*)mQ, (void*)msg, LocMsgDestroy);
     } else {
         LOC_LOGE("%s: msg is %p and this is %p",
@@ -74,15 +397,96 @@ void MsgTask::sendMsg(const LocMsg* msg) const {
     }
 }
 
-void MsgTask::sendMsg(const std::function<void()> runnable) const {
-    struct RunMsg : public LocMsg {
-        const std::function<void()> mRunnable;
-    public:
-        inline RunMsg(const std::function<void()> runnable) : mRunnable(runnable) {}
-        ~RunMsg() = default;
-        inline virtual void proc() const override { mRunnable(); }
-    };
-    sendMsg(new RunMsg(runnable));
+void MsgTask::sendMsg(LocTask&& runnable) const {
+    sendMsg(new (mTaskMsgPool.get()) TaskMsg(std::move(runnable)));
+}
+
+void MsgTask::getLaneStats(LocMsgLane lane, LocMsgLaneStats& stats) const {
+    memset(&stats, 0, sizeof(stats));
+    if (lane >= 0 && lane < LOC_MSG_LANE_MAX) {
+        const LocMsgLaneCounters::Counters& c = mLaneCounters->mLanes[lane];
+        stats.mDepth = c.mDepth.load(std::memory_order_relaxed);
+        stats.mMaxDepth = c.mMaxDepth.load(std::memory_order_relaxed);
+        stats.mProcessed = c.mProcessed.load(std::memory_order_relaxed);
+        stats.mCoalesced = c.mCoalesced.load(std::memory_order_relaxed);
+    }
+}
+
+void MsgTask::dumpProfile(const char* name) const {
+    const LocMsgTaskProfile& p = *mProfile;
+    LOC_LOGi("MsgTask %s profile: %" PRIu64 " msgs, max wait %u us, max proc %u us",
+             name, p.mCount.load(std::memory_order_relaxed),
+             p.mWait.mMaxUs.load(std::memory_order_relaxed),
+             p.mProc.mMaxUs.load(std::memory_order_relaxed));
+    const char* labels[] = {"wait", "proc"};
+    const LocMsgTaskProfile::Histogram* histograms[] = {&p.mWait, &p.mProc};
+    for (int i = 0; i < 2; i++) {
+        std::string line;
+        char bucket[48];
+        for (int b = 0; b < LocMsgTaskProfile::BUCKETS; b++) {
+            uint64_t n = histograms[i]->mBuckets[b].load(std::memory_order_relaxed);
+            if (n > 0 && b < LocMsgTaskProfile::BUCKETS - 1) {
+                snprintf(bucket, sizeof(bucket), " <%uus:%" PRIu64, 1u << b, n);
+                line += bucket;
+            } else if (n > 0) {
+                // the last bucket takes everything above the one before
+                snprintf(bucket, sizeof(bucket), " >=%uus:%" PRIu64, 1u << (b - 1), n);
+                line += bucket;
+            }
+        }
+        LOC_LOGi("MsgTask %s %s histogram:%s", name, labels[i], line.c_str());
+    }
+}
+
+bool MsgTask::writeProfileTrace(const char* filePath) const {
+    std::vector<LocMsgTraceRecord> records;
+    LocMsgTraceHeader header = {LOC_MSG_TRACE_MAGIC, LOC_MSG_TRACE_VERSION,
+                                sizeof(LocMsgTraceRecord), 0};
+    header.mCount = mProfile->snapshotTrace(records);
+
+    FILE* file = fopen(filePath, "wb");
+    if (nullptr == file) {
+        LOC_LOGe("failed to open %s: %s", filePath, strerror(errno));
+        return false;
+    }
+    bool success = (1 == fwrite(&header, sizeof(header), 1, file)) &&
+            (records.size() == fwrite(records.data(), sizeof(LocMsgTraceRecord),
+                                      records.size(), file));
+    fclose(file);
+    return success;
+}
+
+void MTRunnable::stage(LocMsg* msg) {
+    LocMsgLane lane = msg->getLane();
+    if (lane < 0 || lane >= LOC_MSG_LANE_MAX) {
+        lane = LOC_MSG_LANE_CONTROL;
+    }
+    LocMsgLaneCounters::Counters& c = mLaneCounters->mLanes[lane];
+    if (mLanes[lane].push(msg, msg->getCoalesceKey())) {
+        c.mCoalesced.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        mStaged++;
+        uint32_t depth = mLanes[lane].size();
+        c.mDepth.store(depth, std::memory_order_relaxed);
+        if (depth > c.mMaxDepth.load(std::memory_order_relaxed)) {
+            c.mMaxDepth.store(depth, std::memory_order_relaxed);
+        }
+    }
+}
+
+LocMsg* MTRunnable::next(LocMsgLane& msgLane) {
+    for (int lane = 0; lane < LOC_MSG_LANE_MAX; lane++) {
+        if (!mLanes[lane].empty()) {
+            msgLane = (LocMsgLane)lane;
+            LocMsgLaneCounters::Counters& c = mLaneCounters->mLanes[lane];
+            LocMsg* msg = mLanes[lane].pop();
+            mStaged--;
+            c.mDepth.store(mLanes[lane].size(), std::memory_order_relaxed);
+            c.mProcessed.fetch_add(1, std::memory_order_relaxed);
+            return msg;
+        }
+    }
+    return nullptr;
 }
 
 void MTRunnable::interrupt() {
@@ -96,16 +500,38 @@ void MTRunnable::prerun() {
 
 bool MTRunnable::run() {
     LocMsg* msg;
-    msq_q_err_type result = msg_q_rcv((void*)mQ, (void **)&msg);
-    if (eMSG_Q_SUCCESS != result) {
-        LOC_LOGE("%s:%d] fail receiving msg: %s\n", __func__, __LINE__,
-                 loc_get_msg_q_status(result));
+    msq_q_err_type result;
+    // only block when nothing is staged, then take everything else that is
+    // already queued, so that the lanes can be served by priority and
+    // superseded msgs coalesced.
+    if (0 == mStaged) {
+        result = msg_q_rcv((void*)mQ, (void **)&msg);
+        if (eMSG_Q_SUCCESS != result) {
+            LOC_LOGE("%s:%d] fail receiving msg: %s\n", __func__, __LINE__,
+                     loc_get_msg_q_status(result));
+            return false;
+        }
+        stage(msg);
+    }
+    while (eMSG_Q_SUCCESS == (result = msg_q_rmv((void*)mQ, (void **)&msg))) {
+        stage(msg);
+    }
+    if (eMSG_Q_UNAVAILABLE_RESOURCE == result) {
+        // unblocked, the thread is being stopped
         return false;
     }
 
+    LocMsgLane lane = LOC_MSG_LANE_CONTROL;
+    msg = next(lane);
     msg->log();
-    // there is where each individual msg handling is invoked
-    msg->proc();
+    if (0 != msg->mSentTimeNs) {
+        uint64_t startNs = getMonotonicNs();
+        msg->proc();
+        mProfile->record(msg, lane, startNs, getMonotonicNs());
+    } else {
+        // there is where each individual msg handling is invoked
+        msg->proc();
+    }
 
     delete msg;
 
@@ -30,25 +30,224 @@
 #define __MSG_TASK__
 
 #include <functional>
+#include <type_traits>
+#include <utility>
+#include <new>
+#include <cstddef>
+#include <stdint.h>
 #include <LocThread.h>
 
 namespace loc_util {
 
+// A move-only void() callable. Callables that fit in INLINE_SIZE (e.g. a
+// lambda capturing an adapter pointer and a few PODs, or a std::function)
+// are stored in place; only larger ones fall back to the heap.
+class LocTask {
+public:
+    static const size_t INLINE_SIZE = 6 * sizeof(void*);
+
+    inline LocTask() : mOps(nullptr) {}
+    template <typename F, typename = typename std::enable_if<
+            !std::is_same<typename std::decay<F>::type, LocTask>::value>::type>
+    inline LocTask(F&& f) : mOps(nullptr) {
+        emplace(std::forward<F>(f), FitsInline<typename std::decay<F>::type>());
+    }
+    inline LocTask(LocTask&& other) noexcept : mOps(other.mOps) {
+        if (nullptr != mOps) {
+            mOps->move(mStorage, other.mStorage);
+            other.mOps = nullptr;
+        }
+    }
+    inline LocTask& operator=(LocTask&& other) noexcept {
+        if (this != &other) {
+            reset();
+            mOps = other.mOps;
+            if (nullptr != mOps) {
+                mOps->move(mStorage, other.mStorage);
+                other.mOps = nullptr;
+            }
+        }
+        return *this;
+    }
+    LocTask(const LocTask&) = delete;
+    LocTask& operator=(const LocTask&) = delete;
+    inline ~LocTask() { reset(); }
+
+    inline explicit operator bool() const { return nullptr != mOps; }
+    inline void operator()() const {
+        if (nullptr != mOps) {
+            mOps->invoke(mStorage);
+        }
+    }
+    inline void reset() {
+        if (nullptr != mOps) {
+            mOps->destroy(mStorage);
+            mOps = nullptr;
+        }
+    }
+
+private:
+    struct Ops {
+        void (*invoke)(void* storage);
+        // move constructs into dst and destroys what is left in src
+        void (*move)(void* dst, void* src);
+        void (*destroy)(void* storage);
+    };
+    template <typename Func>
+    struct FitsInline : std::integral_constant<bool,
+            sizeof(Func) <= INLINE_SIZE &&
+            alignof(Func) <= alignof(std::max_align_t) &&
+            std::is_nothrow_move_constructible<Func>::value> {};
+    template <typename Func>
+    struct InlineOps {
+        static void invoke(void* s) { (*static_cast<Func*>(s))(); }
+        static void move(void* d, void* s) {
+            new (d) Func(std::move(*static_cast<Func*>(s)));
+            static_cast<Func*>(s)->~Func();
+        }
+        static void destroy(void* s) { static_cast<Func*>(s)->~Func(); }
+        static const Ops ops;
+    };
+    template <typename Func>
+    struct HeapOps {
+        static void invoke(void* s) { (**static_cast<Func**>(s))(); }
+        static void move(void* d, void* s) { *static_cast<Func**>(d) = *static_cast<Func**>(s); }
+        static void destroy(void* s) { delete *static_cast<Func**>(s); }
+        static const Ops ops;
+    };
+
+    // the storage is picked at compile time, so the placement new is only
+    // compiled for the callables that fit
+    template <typename F>
+    inline void emplace(F&& f, std::true_type /*inline*/) {
+        typedef typename std::decay<F>::type Func;
+        new (mStorage) Func(std::forward<F>(f));
+        mOps = &InlineOps<Func>::ops;
+    }
+    template <typename F>
+    inline void emplace(F&& f, std::false_type /*inline*/) {
+        typedef typename std::decay<F>::type Func;
+        *reinterpret_cast<Func**>(mStorage) = new Func(std::forward<F>(f));
+        mOps = &HeapOps<Func>::ops;
+    }
+
+    alignas(std::max_align_t) mutable unsigned char mStorage[INLINE_SIZE];
+    const Ops* mOps;
+};
+
+template <typename Func>
+const LocTask::Ops LocTask::InlineOps<Func>::ops = {
+    &LocTask::InlineOps<Func>::invoke,
+    &LocTask::InlineOps<Func>::move,
+    &LocTask::InlineOps<Func>::destroy
+};
+
+template <typename Func>
+const LocTask::Ops LocTask::HeapOps<Func>::ops = {
+    &LocTask::HeapOps<Func>::invoke,
+    &LocTask::HeapOps<Func>::move,
+    &LocTask::HeapOps<Func>::destroy
+};
+
+// One processed msg in the binary trace written by
+// MsgTask::writeProfileTrace(). The file is a LocMsgTraceHeader followed by
+// mCount records, oldest first.
+struct LocMsgTraceRecord {
+    uint64_t mSentTimeNs;        // CLOCK_MONOTONIC
+    uint32_t mWaitUs;            // from send to start of proc()
+    uint32_t mProcUs;            // duration of proc()
+    uint64_t mTypeId;            // vtable address of the msg; symbolize
+                                 // against the loaded libraries offline
+    uint32_t mLane;              // LocMsgLane
+    uint32_t mReserved;
+};
+
+#define LOC_MSG_TRACE_MAGIC   0x4C4D5452 // "LMTR"
+#define LOC_MSG_TRACE_VERSION 1
+
+struct LocMsgTraceHeader {
+    uint32_t mMagic;
+    uint32_t mVersion;
+    uint32_t mRecordSize;
+    uint32_t mCount;
+};
+
+// opaque per MsgTask pool of recycled task msg slots
+class LocTaskMsgPool;
+// opaque per MsgTask lane counters
+class LocMsgLaneCounters;
+// opaque per MsgTask latency histograms and trace
+class LocMsgTaskProfile;
+
+// Priority lanes of a MsgTask, highest first. Queued msgs of a higher lane
+// are processed before those of a lower one; within a lane order is FIFO.
+typedef enum {
+    LOC_MSG_LANE_CONTROL = 0,    // commands, responses, anything not tagged
+    LOC_MSG_LANE_POSITION,       // position reports and the SV, NMEA and data
+                                 // reports that must stay in order with them
+    LOC_MSG_LANE_BULK,           // high rate telemetry independent of the fix,
+                                 // e.g. measurements
+    LOC_MSG_LANE_MAX
+} LocMsgLane;
+
 struct LocMsg {
-    inline LocMsg() {}
+    // CLOCK_MONOTONIC ns when last sent, 0 unless msg task profiling is on
+    mutable uint64_t mSentTimeNs;
+
+    inline LocMsg() : mSentTimeNs(0) {}
     inline virtual ~LocMsg() {}
     virtual void proc() const = 0;
     inline virtual void log() const {}
+    inline virtual LocMsgLane getLane() const { return LOC_MSG_LANE_CONTROL; }
+    // A non 0 key makes this msg supersede a msg of the same lane and key
+    // that is still queued; it takes over its place in the queue and the
+    // older msg is deleted without being processed.
+    inline virtual uint64_t getCoalesceKey() const { return 0; }
+
+    // kind distinguishes the msg types of a sender, value e.g. the sender
+    // object; only the low 56 bits of value are used.
+    static inline uint64_t makeCoalesceKey(uint8_t kind, uint64_t value) {
+        return ((uint64_t)kind << 56) | (value & 0x00ffffffffffffffULL);
+    }
+};
+
+struct LocMsgLaneStats {
+    uint32_t mDepth;             // msgs queued in the lane
+    uint32_t mMaxDepth;          // high water mark of mDepth
+    uint64_t mProcessed;         // msgs processed
+    uint64_t mCoalesced;         // msgs dropped as superseded
 };
 
 class MsgTask {
     const void* mQ;
+    shared_ptr<LocTaskMsgPool> mTaskMsgPool;
+    shared_ptr<LocMsgLaneCounters> mLaneCounters;
+    shared_ptr<LocMsgTaskProfile> mProfile;
     LocThread mThread;
 public:
+    // ring size for the threads that carry high rate reports
+    static const uint32_t HIGH_RATE_RING_SIZE = 256;
+
     ~MsgTask() = default;
-    MsgTask(const char* threadName = NULL);
+    // ringSize of 0 uses the list based msg_q; otherwise the msg_q is
+    // backed by a lock free ring of ringSize slots, see msg_q_init_ring().
+    MsgTask(const char* threadName = NULL, uint32_t ringSize = 0);
     void sendMsg(const LocMsg* msg) const;
-    void sendMsg(const std::function<void()> runnable) const;
+    // The runnable is moved into a msg slot recycled from a per MsgTask
+    // free list, so that steady state dispatch does no malloc / free.
+    void sendMsg(LocTask&& runnable) const;
+    template <typename F, typename = typename std::enable_if<
+            !std::is_convertible<F, const LocMsg*>::value>::type>
+    inline void sendMsg(F&& runnable) const {
+        sendMsg(LocTask(std::forward<F>(runnable)));
+    }
+    void getLaneStats(LocMsgLane lane, LocMsgLaneStats& stats) const;
+    // Only populated while MSG_TASK_PROFILING_ENABLED is set in gps.conf.
+    // logs the queue wait / proc time histograms, which also puts them in
+    // LogBuffer when that is enabled.
+    void dumpProfile(const char* name) const;
+    // writes the most recent msg trace records; returns false on failure
+    bool writeProfileTrace(const char* filePath) const;
 };
 
 } //
@@ -43,6 +43,7 @@
 #include <loc_pla.h>
 #include <loc_target.h>
 #include <loc_misc_utils.h>
+#include <loc_timer.h>
 #ifdef USE_GLIB
 #include <glib.h>
 #endif
@@ -60,6 +61,9 @@ static uint32_t TIMESTAMP = 0;
 static uint32_t DATUM_TYPE = 0;
 static bool sVendorEnhanced = true;
 static uint32_t sLogBufferEnabled = 0;
+static uint32_t sLogBufferBinary = 0;
+static uint32_t sMsgTaskProfilingEnabled = 0;
+static uint32_t sTimerSlackMs = 0;
 
 /* Parameter spec table */
 static const loc_param_s_type loc_param_table[] =
@@ -68,6 +72,9 @@ static const loc_param_s_type loc_param_table[] =
     {"TIMESTAMP",               &TIMESTAMP,          NULL, 'n'},
     {"DATUM_TYPE",              &DATUM_TYPE,         NULL, 'n'},
     {"LOG_BUFFER_ENABLED",      &sLogBufferEnabled,  NULL, 'n'},
+    {"LOG_BUFFER_BINARY",       &sLogBufferBinary,   NULL, 'n'},
+    {"MSG_TASK_PROFILING_ENABLED", &sMsgTaskProfilingEnabled, NULL, 'n'},
+    {"TIMER_SLACK_MS",          &sTimerSlackMs,      NULL, 'n'},
 };
 static const int loc_param_num = sizeof(loc_param_table) / sizeof(loc_param_s_type);
 
@@ -453,6 +460,9 @@ void loc_read_conf_long(const char* conf_file_name, const loc_param_s_type* conf
     /* Initialize logging mechanism with parsed data */
     loc_logger_init(DEBUG_LEVEL, TIMESTAMP);
     log_buffer_init(sLogBufferEnabled);
+    log_buffer_binary_init(sLogBufferBinary);
+    msg_task_profiling_init(sMsgTaskProfilingEnabled);
+    loc_timer_set_slack(sTimerSlackMs);
     log_tag_level_map_init();
 }
 
@@ -43,6 +43,7 @@
 #include <algorithm>
 #include <string>
 #include <cctype>
+#include <mutex>
 #define  BUFFER_SIZE  120
 #define  LOG_TAG_LEVEL_CONF_FILE_PATH "/data/vendor/location/gps.prop"
 
@@ -67,6 +68,12 @@ loc_logger_s_type loc_logger;
 /* tag base logging control map*/
 static std::unordered_map<std::string, uint8_t> tag_level_map;
 static bool tag_map_inited = false;
+/* level slots per tag, never freed as the source files pointing to them
+   may live in libraries loaded and unloaded at any time */
+#define MAX_TAG_LEVEL_SLOTS 256
+static int tag_level_slots[MAX_TAG_LEVEL_SLOTS];
+static std::unordered_map<std::string, int*> tag_slot_map;
+static std::mutex tag_slot_lock;
 
 /* returns the least signification bit that is set in the mask
    Param
@@ -225,13 +232,45 @@ void log_buffer_insert(char *str, unsigned long buf_size, int level)
     timespec tv;
     clock_gettime(CLOCK_BOOTTIME, &tv);
     uint64_t elapsedTime = (uint64_t)tv.tv_sec + (uint64_t)tv.tv_nsec/1000000000;
-    string ss = str;
-    loc_util::LogBuffer::getInstance()->append(ss, level, elapsedTime);
+    loc_util::LogBuffer::getInstance()->append(str, strnlen(str, buf_size), level, elapsedTime);
+}
+
+/*===========================================================================
+
+FUNCTION log_buffer_insert_binary
+
+DESCRIPTION
+   Insert a binary record of log_buffer_insert_args() with specific level to
+   the log buffer, it is formatted when the buffer is dumped.
+
+RETURN VALUE
+   N/A
+
+===========================================================================*/
+void log_buffer_insert_binary(const char *rec, unsigned long len, int level)
+{
+    timespec tv;
+    clock_gettime(CLOCK_BOOTTIME, &tv);
+    uint64_t elapsedTime = (uint64_t)tv.tv_sec + (uint64_t)tv.tv_nsec/1000000000;
+    loc_util::LogBuffer::getInstance()->append(rec, len, level, elapsedTime,
+                                               loc_util::LogBuffer::FLAG_BINARY);
+}
+
+/* recomputes the levels in the slots of all the tags resolved so far */
+static void log_tag_level_refresh()
+{
+    std::lock_guard<std::mutex> guard(tag_slot_lock);
+    for (auto& entry : tag_slot_map) {
+        __atomic_store_n(entry.second, get_tag_log_level(entry.first.c_str()),
+                         __ATOMIC_RELAXED);
+    }
 }
 
 void log_tag_level_map_init()
 {
     if (tag_map_inited) {
+        // gps.conf read again, the global level may have changed
+        log_tag_level_refresh();
         return;
     }
 
@@ -280,3 +319,43 @@ int get_tag_log_level(const char* tag)
     }
     return log_level;
 }
+
+/*===========================================================================
+
+FUNCTION log_tag_level_resolve
+
+DESCRIPTION
+   Resolves the log level of the tag and points the slot of a source file to
+   the level slot of the tag, which later log_tag_level_map_init() calls keep
+   up to date.
+
+RETURN VALUE
+   The log level, -1 if the tag level map isn't initialized yet.
+
+===========================================================================*/
+int log_tag_level_resolve(int** slot, const char* tag)
+{
+    if (!tag_map_inited) {
+        return -1;
+    }
+    if (tag == NULL) {
+        return loc_logger.DEBUG_LEVEL;
+    }
+
+    std::lock_guard<std::mutex> guard(tag_slot_lock);
+    int level = get_tag_log_level(tag);
+    int* tagSlot = NULL;
+    auto search = tag_slot_map.find(tag);
+    if (tag_slot_map.end() != search) {
+        tagSlot = search->second;
+    } else if (tag_slot_map.size() < MAX_TAG_LEVEL_SLOTS) {
+        tagSlot = &tag_level_slots[tag_slot_map.size()];
+        tag_slot_map[tag] = tagSlot;
+    }
+    // out of slots, the tag is resolved on every call
+    if (tagSlot != NULL) {
+        __atomic_store_n(tagSlot, level, __ATOMIC_RELAXED);
+        __atomic_store_n(slot, tagSlot, __ATOMIC_RELEASE);
+    }
+    return level;
+}
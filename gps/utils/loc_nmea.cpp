@@ -31,9 +31,16 @@
 #define LOG_TAG "LocSvc_nmea"
 #include <loc_nmea.h>
 #include <math.h>
+#include <string.h>
 #include <log_util.h>
 #include <loc_pla.h>
 #include <loc_cfg.h>
+#include <mutex>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
 
 #define GLONASS_SV_ID_OFFSET 64
 #define QZSS_SV_ID_OFFSET    (192)
@@ -42,6 +49,7 @@
 #define NAVIC_SV_ID_OFFSET   (400)
 #define MAX_SV_COUNT_SUPPORTED_IN_ONE_CONSTELLATION  64
 #define MAX_SATELLITES_IN_USE 12
+#define LOC_NMEA_CHECKSUM_LENGTH 5 // "*XX\r\n"
 #define MSEC_IN_ONE_WEEK      604800000ULL
 #define UTC_GPS_OFFSET_MSECS  315964800000ULL
 
@@ -150,6 +158,44 @@ typedef struct loc_sv_cache_info_s
     float vdop;
 } loc_sv_cache_info;
 
+typedef struct loc_nmea_gsv_sv_s
+{
+    int32_t svId;
+    int32_t elevation;
+    int32_t azimuth;
+    int32_t hasCN0;
+    int32_t cN0;
+} loc_nmea_gsv_sv;
+
+// everything a GSV page is rendered from
+typedef struct loc_nmea_gsv_key_s
+{
+    int32_t sentenceCount;
+    int32_t svCount;
+    int32_t count;
+    loc_nmea_gsv_sv svs[4];
+} loc_nmea_gsv_key;
+
+typedef struct loc_nmea_gsv_page_s
+{
+    loc_nmea_gsv_key key;
+    int length;         // 0 when the page is not valid
+    char sentence[NMEA_SENTENCE_MAX_LENGTH];
+} loc_nmea_gsv_page;
+
+// GSV pages of one constellation and signal as rendered for the last report
+typedef struct loc_nmea_gsv_cache_s
+{
+    LocGnssConstellationType svType;
+    uint32_t signalId;
+    std::vector<loc_nmea_gsv_page> pages;
+} loc_nmea_gsv_cache;
+
+static std::mutex sGsvCacheLock;
+static std::vector<loc_nmea_gsv_cache> sGsvCache;
+static uint64_t sGsvCacheHits = 0;
+static uint64_t sGsvCacheMisses = 0;
+
 /*===========================================================================
 FUNCTION    convert_Lla_to_Ecef
 
@@ -547,6 +593,87 @@ static loc_nmea_sv_meta* loc_nmea_sv_meta_init(loc_nmea_sv_meta& sv_meta,
     return &sv_meta;
 }
 
+/*===========================================================================
+FUNCTION    loc_nmea_checksum
+
+DESCRIPTION
+   XOR of all the bytes of data, 16 bytes at a time with SSE2 or NEON where
+   available, then 8 bytes at a time, then byte by byte for the tail
+
+DEPENDENCIES
+   NONE
+
+RETURN VALUE
+   NMEA checksum of data
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+static uint8_t loc_nmea_checksum(const char *data, size_t length)
+{
+    size_t i = 0;
+    uint64_t acc = 0;
+
+#if defined(__SSE2__)
+    if (length >= 16) {
+        __m128i v = _mm_setzero_si128();
+        for (; i + 16 <= length; i += 16) {
+            v = _mm_xor_si128(v, _mm_loadu_si128((const __m128i*)(data + i)));
+        }
+        uint64_t lanes[2];
+        _mm_storeu_si128((__m128i*)lanes, v);
+        acc = lanes[0] ^ lanes[1];
+    }
+#elif defined(__ARM_NEON)
+    if (length >= 16) {
+        uint8x16_t v = vdupq_n_u8(0);
+        for (; i + 16 <= length; i += 16) {
+            v = veorq_u8(v, vld1q_u8((const uint8_t*)(data + i)));
+        }
+        uint64x2_t lanes = vreinterpretq_u64_u8(v);
+        acc = vgetq_lane_u64(lanes, 0) ^ vgetq_lane_u64(lanes, 1);
+    }
+#endif
+    for (; i + sizeof(acc) <= length; i += sizeof(acc)) {
+        uint64_t word;
+        memcpy(&word, data + i, sizeof(word));
+        acc ^= word;
+    }
+    acc ^= acc >> 32;
+    acc ^= acc >> 16;
+    acc ^= acc >> 8;
+
+    uint8_t checksum = (uint8_t)(acc & 0xFF);
+    for (; i < length; i++) {
+        checksum ^= (uint8_t)data[i];
+    }
+    return checksum;
+}
+
+/* appends "*XX\r\n" to the sentence of length bytes in pNmea, returns the
+   total length of the sentence */
+static int loc_nmea_append_checksum(char *pNmea, int length, int maxSize)
+{
+    static const char hexDigits[] = "0123456789ABCDEF";
+
+    if (length <= 0 || maxSize - length < LOC_NMEA_CHECKSUM_LENGTH + 1)
+    {
+        return length;
+    }
+    // checksum is over the bytes between $ and *
+    uint8_t checksum = loc_nmea_checksum(pNmea + 1, length - 1);
+    pNmea += length;
+    pNmea[0] = '*';
+    pNmea[1] = hexDigits[checksum >> 4];
+    pNmea[2] = hexDigits[checksum & 0xF];
+    pNmea[3] = '\r';
+    pNmea[4] = '\n';
+    pNmea[5] = '\0';
+
+    return (length + LOC_NMEA_CHECKSUM_LENGTH);
+}
+
 /*===========================================================================
 FUNCTION    loc_nmea_put_checksum
 
@@ -565,24 +692,145 @@ SIDE EFFECTS
 ===========================================================================*/
 static int loc_nmea_put_checksum(char *pNmea, int maxSize)
 {
-    uint8_t checksum = 0;
-    int length = 0;
     if(NULL == pNmea)
         return 0;
 
-    pNmea++; //skip the $
-    while (*pNmea != '\0')
-    {
-        checksum ^= *pNmea++;
-        length++;
-    }
+    return loc_nmea_append_checksum(pNmea, strlen(pNmea), maxSize);
+}
 
-    // length now contains nmea sentence string length not including $ sign.
-    int checksumLength = snprintf(pNmea,(maxSize-length-1),"*%02X\r\n", checksum);
+/* Formats the fields of one sentence into a buffer, numbers with integer
+   and fixed-point arithmetic instead of snprintf. Room for the checksum is
+   kept at the end of the buffer. */
+class LocNmeaWriter {
+    char* const mStart;
+    char* mPos;
+    char* const mEnd;
+    bool mOverflow;
+
+    inline void mem(const char* s, size_t length) {
+        if ((size_t)(mEnd - mPos) >= length) {
+            memcpy(mPos, s, length);
+            mPos += length;
+        } else {
+            mOverflow = true;
+        }
+    }
+    // two digits at a time from a table of "00" to "99"
+    inline void digits(uint64_t v, int width) {
+        static const char digitPairs[] =
+            "0001020304050607080910111213141516171819"
+            "2021222324252627282930313233343536373839"
+            "4041424344454647484950515253545556575859"
+            "6061626364656667686970717273747576777879"
+            "8081828384858687888990919293949596979899";
+        char tmp[20];
+        int n = sizeof(tmp);
+        while (v >= 100) {
+            uint32_t pair = (uint32_t)(v % 100);
+            v /= 100;
+            n -= 2;
+            memcpy(tmp + n, digitPairs + 2 * pair, 2);
+        }
+        if (v >= 10) {
+            n -= 2;
+            memcpy(tmp + n, digitPairs + 2 * v, 2);
+        } else {
+            tmp[--n] = '0' + (char)v;
+        }
+        for (width -= (int)sizeof(tmp) - n; width > 0; width--) {
+            chr('0');
+        }
+        mem(tmp + n, sizeof(tmp) - n);
+    }
+public:
+    inline LocNmeaWriter(char* buf, int bufSize) :
+        mStart(buf), mPos(buf),
+        mEnd(buf + ((bufSize > LOC_NMEA_CHECKSUM_LENGTH + 1) ?
+                    (bufSize - LOC_NMEA_CHECKSUM_LENGTH - 1) : 0)),
+        mOverflow(false) {}
+    inline bool ok() const { return !mOverflow; }
+    inline LocNmeaWriter& chr(char c) {
+        if (mPos < mEnd) {
+            *mPos++ = c;
+        } else {
+            mOverflow = true;
+        }
+        return *this;
+    }
+    inline LocNmeaWriter& str(const char* s) {
+        mem(s, strlen(s));
+        return *this;
+    }
+    // as "%0<width>d"
+    inline LocNmeaWriter& num(int64_t v, int width = 0) {
+        if (v < 0) {
+            chr('-');
+            digits(-(uint64_t)v, width - 1);
+        } else {
+            digits(v, width);
+        }
+        return *this;
+    }
+    // as "%X"
+    inline LocNmeaWriter& hex(uint32_t v) {
+        static const char hexDigits[] = "0123456789ABCDEF";
+        int shift = 28;
+        while (shift > 0 && 0 == (v >> shift)) {
+            shift -= 4;
+        }
+        for (; shift >= 0; shift -= 4) {
+            chr(hexDigits[(v >> shift) & 0xF]);
+        }
+        return *this;
+    }
+    // as "%0<intDigits + 1 + decimals>.<decimals>f", decimals <= 6
+    inline LocNmeaWriter& fixed(double v, int decimals, int intDigits = 1) {
+        static const uint64_t scale[] = {1, 10, 100, 1000, 10000, 100000, 1000000};
+        double scaled = fabs(v) * scale[decimals];
+        double rounded = nearbyint(scaled);
+        // nan, inf, out of range or so close to a rounding tie that the
+        // scaled product may round other than the exact value, leave these
+        // rare cases to snprintf so that the output is always the same
+        if (!(scaled < 1e9) || fabs(scaled - rounded) > 0.5 - 1e-6) {
+            char tmp[NMEA_SENTENCE_MAX_LENGTH];
+            snprintf(tmp, sizeof(tmp), "%0*.*f",
+                     (intDigits > 1) ? (intDigits + 1 + decimals) : 0, decimals, v);
+            return str(tmp);
+        }
+        // the sign takes a digit of the zero padding
+        if (signbit(v)) {
+            chr('-');
+            intDigits--;
+        }
+        uint64_t n = (uint64_t)rounded;
+        digits(n / scale[decimals], intDigits);
+        if (decimals > 0) {
+            chr('.');
+            digits(n % scale[decimals], decimals);
+        }
+        return *this;
+    }
+    // terminates the sentence with its checksum, returns its length
+    inline int finish() {
+        *mPos = '\0';
+        return loc_nmea_append_checksum(mStart, mPos - mStart,
+                                        mPos - mStart + LOC_NMEA_CHECKSUM_LENGTH + 1);
+    }
+};
 
-    // total length of nmea sentence is length of nmea sentence inc $ sign plus
-    // length of checksum (+1 is to cover the $ character in the length).
-    return (length + checksumLength + 1);
+/* appends a sentence with checksum to the sentences of the epoch */
+static void loc_nmea_epoch_append(LocNmeaEpoch &nmea, const char* sentence, int length)
+{
+    if (length <= 0 || nmea.count >= NMEA_EPOCH_MAX_SENTENCES ||
+        nmea.length + length >= nmea.size)
+    {
+        LOC_LOGE("NMEA Error epoch buffer full, sentences: %u", nmea.count);
+        return;
+    }
+    nmea.offsets[nmea.count++] = nmea.length;
+    memcpy(nmea.buf + nmea.length, sentence, length);
+    nmea.length += length;
+    nmea.buf[nmea.length] = '\0';
 }
 
 /*===========================================================================
@@ -610,7 +858,7 @@ static uint32_t loc_nmea_generate_GSA(const GpsLocationExtended &locationExtende
                               char* sentence,
                               int bufSize,
                               loc_nmea_sv_meta* sv_meta_p,
-                              std::vector<std::string> &nmeaArraystr)
+                              LocNmeaEpoch &nmea)
 {
     if (!sentence || bufSize <= 0 || !sv_meta_p)
     {
@@ -618,9 +866,7 @@ static uint32_t loc_nmea_generate_GSA(const GpsLocationExtended &locationExtende
         return 0;
     }
 
-    char* pMarker = sentence;
-    int lengthRemaining = bufSize;
-    int length = 0;
+    LocNmeaWriter w(sentence, bufSize);
 
     uint32_t svUsedCount = 0;
     uint32_t svUsedList[64] = {0};
@@ -662,56 +908,39 @@ static uint32_t loc_nmea_generate_GSA(const GpsLocationExtended &locationExtende
     // v.v : Vertical DOP
     // s : GNSS System Id
     // cc : Checksum value
-    length = snprintf(pMarker, lengthRemaining, "$%sGSA,A,%c,", talker, fixType);
-
-    if (length < 0 || length >= lengthRemaining)
-    {
-        LOC_LOGE("NMEA Error in string formatting");
-        return 0;
-    }
-    pMarker += length;
-    lengthRemaining -= length;
+    w.chr('$').str(talker).str("GSA,A,").chr(fixType).chr(',');
 
     // Add first 12 satellite IDs
     for (uint8_t i = 0; i < 12; i++)
     {
         if (i < svUsedCount)
-            length = snprintf(pMarker, lengthRemaining, "%02d,", svUsedList[i]);
-        else
-            length = snprintf(pMarker, lengthRemaining, ",");
-
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return 0;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
+            w.num((int)svUsedList[i], 2);
+        w.chr(',');
     }
 
     // Add the position/horizontal/vertical DOP values
     if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_DOP)
     {
-        length = snprintf(pMarker, lengthRemaining, "%.1f,%.1f,%.1f,",
-                locationExtended.pdop,
-                locationExtended.hdop,
-                locationExtended.vdop);
+        w.fixed(locationExtended.pdop, 1).chr(',')
+         .fixed(locationExtended.hdop, 1).chr(',')
+         .fixed(locationExtended.vdop, 1).chr(',');
     }
     else
     {   // no dop
-        length = snprintf(pMarker, lengthRemaining, ",,,");
+        w.str(",,,");
     }
-    pMarker += length;
-    lengthRemaining -= length;
 
     // system id
-    length = snprintf(pMarker, lengthRemaining, "%d", sv_meta_p->systemId);
-    pMarker += length;
-    lengthRemaining -= length;
+    w.num(sv_meta_p->systemId);
+
+    if (!w.ok())
+    {
+        LOC_LOGE("NMEA Error in string formatting");
+        return 0;
+    }
 
     /* Sentence is ready, add checksum and broadcast */
-    length = loc_nmea_put_checksum(sentence, bufSize);
-    nmeaArraystr.push_back(sentence);
+    loc_nmea_epoch_append(nmea, sentence, w.finish());
 
     return svUsedCount;
 }
@@ -740,7 +969,7 @@ static void loc_nmea_generate_GSV(const GnssSvNotification &svNotify,
                               char* sentence,
                               int bufSize,
                               loc_nmea_sv_meta* sv_meta_p,
-                              std::vector<std::string> &nmeaArraystr)
+                              LocNmeaEpoch &nmea)
 {
     if (!sentence || bufSize <= 0)
     {
@@ -748,9 +977,6 @@ static void loc_nmea_generate_GSV(const GnssSvNotification &svNotify,
         return;
     }
 
-    char* pMarker = sentence;
-    int lengthRemaining = bufSize;
-    int length = 0;
     int sentenceCount = 0;
     int sentenceNumber = 1;
     size_t svNumber = 1;
@@ -771,21 +997,28 @@ static void loc_nmea_generate_GSV(const GnssSvNotification &svNotify,
     sentenceNumber = 1;
     sentenceCount = svCount / 4 + (svCount % 4 != 0);
 
+    std::lock_guard<std::mutex> guard(sGsvCacheLock);
+    loc_nmea_gsv_cache* cache = NULL;
+    for (auto& it : sGsvCache) {
+        if (it.svType == sv_meta_p->svType && it.signalId == sv_meta_p->signalId) {
+            cache = &it;
+            break;
+        }
+    }
+    if (NULL == cache) {
+        sGsvCache.push_back({sv_meta_p->svType, sv_meta_p->signalId, {}});
+        cache = &sGsvCache.back();
+    }
+    if (cache->pages.size() < (size_t)sentenceCount) {
+        cache->pages.resize(sentenceCount);
+    }
+
     while (sentenceNumber <= sentenceCount)
     {
-        pMarker = sentence;
-        lengthRemaining = bufSize;
-
-        length = snprintf(pMarker, lengthRemaining, "$%sGSV,%d,%d,%02d",
-                talker, sentenceCount, sentenceNumber, svCount);
-
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
+        loc_nmea_gsv_key key;
+        memset(&key, 0, sizeof(key));
+        key.sentenceCount = sentenceCount;
+        key.svCount = svCount;
 
         for (int i=0; (svNumber <= svNotify.count) && (i < 4);  svNumber++)
         {
@@ -825,45 +1058,68 @@ static void loc_nmea_generate_GSV(const GnssSvNotification &svNotify,
             if (sv_meta_p->svType == svNotify.gnssSvs[svNumber - 1].type &&
                     sv_meta_p->signalId == convert_signalType_to_signalId(signalType))
             {
-                length = snprintf(pMarker, lengthRemaining,",%02d,%02d,%03d,",
-                        svNotify.gnssSvs[svNumber - 1].svId - svIdOffset,
-                        (int)(0.5 + svNotify.gnssSvs[svNumber - 1].elevation), //float to int
-                        (int)(0.5 + svNotify.gnssSvs[svNumber - 1].azimuth)); //float to int
-
-                if (length < 0 || length >= lengthRemaining)
-                {
-                    LOC_LOGE("NMEA Error in string formatting");
-                    return;
-                }
-                pMarker += length;
-                lengthRemaining -= length;
-
+                loc_nmea_gsv_sv& sv = key.svs[i];
+                sv.svId = (int32_t)(svNotify.gnssSvs[svNumber - 1].svId - svIdOffset);
+                sv.elevation = (int32_t)(0.5 + svNotify.gnssSvs[svNumber - 1].elevation);
+                sv.azimuth = (int32_t)(0.5 + svNotify.gnssSvs[svNumber - 1].azimuth);
                 if (svNotify.gnssSvs[svNumber - 1].cN0Dbhz > 0)
                 {
-                    length = snprintf(pMarker, lengthRemaining,"%02d",
-                            (int)(0.5 + svNotify.gnssSvs[svNumber - 1].cN0Dbhz)); //float to int
-
-                    if (length < 0 || length >= lengthRemaining)
-                    {
-                        LOC_LOGE("NMEA Error in string formatting");
-                        return;
-                    }
-                    pMarker += length;
-                    lengthRemaining -= length;
+                    sv.hasCN0 = 1;
+                    sv.cN0 = (int32_t)(0.5 + svNotify.gnssSvs[svNumber - 1].cN0Dbhz);
                 }
-
                 i++;
+                key.count = i;
             }
 
         }
 
+        // only pages whose SVs changed since the last report are rendered again
+        loc_nmea_gsv_page& page = cache->pages[sentenceNumber - 1];
+        if (page.length > 0 && 0 == memcmp(&page.key, &key, sizeof(key)))
+        {
+            sGsvCacheHits++;
+            loc_nmea_epoch_append(nmea, page.sentence, page.length);
+            sentenceNumber++;
+            continue;
+        }
+        sGsvCacheMisses++;
+        page.length = 0;
+
+        LocNmeaWriter w(sentence, bufSize);
+
+        w.chr('$').str(talker).str("GSV,").num(sentenceCount).chr(',')
+         .num(sentenceNumber).chr(',').num(svCount, 2);
+
+        for (int i = 0; i < key.count; i++)
+        {
+            w.chr(',').num(key.svs[i].svId, 2)
+             .chr(',').num(key.svs[i].elevation, 2)
+             .chr(',').num(key.svs[i].azimuth, 3)
+             .chr(',');
+
+            if (key.svs[i].hasCN0)
+            {
+                w.num(key.svs[i].cN0, 2);
+            }
+        }
+
         // append signalId
-        length = snprintf(pMarker, lengthRemaining,",%X",sv_meta_p->signalId);
-        pMarker += length;
-        lengthRemaining -= length;
+        w.chr(',').hex(sv_meta_p->signalId);
+
+        if (!w.ok())
+        {
+            LOC_LOGE("NMEA Error in string formatting");
+            return;
+        }
 
-        length = loc_nmea_put_checksum(sentence, bufSize);
-        nmeaArraystr.push_back(sentence);
+        int length = w.finish();
+        if (length < (int)sizeof(page.sentence))
+        {
+            page.key = key;
+            memcpy(page.sentence, sentence, length);
+            page.length = length;
+        }
+        loc_nmea_epoch_append(nmea, sentence, length);
         sentenceNumber++;
 
     }  //while
@@ -879,21 +1135,19 @@ DEPENDENCIES
    NONE
 
 RETURN VALUE
-   NONE
+   Length of the DTM sentence, 0 on error
 
 SIDE EFFECTS
    N/A
 
 ===========================================================================*/
-static void loc_nmea_generate_DTM(const LocLla &ref_lla,
-                                  const LocLla &local_lla,
-                                  char *talker,
-                                  char *sentence,
-                                  int bufSize)
+static int loc_nmea_generate_DTM(const LocLla &ref_lla,
+                                 const LocLla &local_lla,
+                                 char *talker,
+                                 char *sentence,
+                                 int bufSize)
 {
-    char* pMarker = sentence;
-    int lengthRemaining = bufSize;
-    int length = 0;
+    LocNmeaWriter w(sentence, bufSize);
     int datum_type;
     char ref_datum[4] = {0};
     char local_datum[4] = {0};
@@ -924,13 +1178,7 @@ static void loc_nmea_generate_DTM(const LocLla &ref_lla,
         default:
             break;
     }
-    length = snprintf(pMarker , lengthRemaining , "$%sDTM,%s,," , talker, local_datum);
-    if (length < 0 || length >= lengthRemaining) {
-        LOC_LOGE("NMEA Error in string formatting");
-        return;
-    }
-    pMarker += length;
-    lengthRemaining -= length;
+    w.chr('$').str(talker).str("DTM,").str(local_datum).str(",,");
 
     lla_offset[0] = local_lla.lat - ref_lla.lat;
     lla_offset[1] = fmod(local_lla.lon - ref_lla.lon, 360.0);
@@ -954,24 +1202,16 @@ static void loc_nmea_generate_DTM(const LocLla &ref_lla,
         longHem = 'E';
     }
     longMins = fmod(lla_offset[1] * 60.0, 60.0);
-    length = snprintf(pMarker, lengthRemaining, "%02d%09.6lf,%c,%03d%09.6lf,%c,%.3lf,",
-                     (uint8_t)floor(lla_offset[0]), latMins, latHem,
-                     (uint8_t)floor(lla_offset[1]), longMins, longHem, lla_offset[2]);
-    if (length < 0 || length >= lengthRemaining) {
-        LOC_LOGE("NMEA Error in string formatting");
-        return;
-    }
-    pMarker += length;
-    lengthRemaining -= length;
-    length = snprintf(pMarker , lengthRemaining , "%s" , ref_datum);
-    if (length < 0 || length >= lengthRemaining) {
+    w.num((uint8_t)floor(lla_offset[0]), 2).fixed(latMins, 6, 2).chr(',').chr(latHem).chr(',')
+     .num((uint8_t)floor(lla_offset[1]), 3).fixed(longMins, 6, 2).chr(',').chr(longHem).chr(',')
+     .fixed(lla_offset[2], 3).chr(',');
+    w.str(ref_datum);
+    if (!w.ok()) {
         LOC_LOGE("NMEA Error in string formatting");
-        return;
+        return 0;
     }
-    pMarker += length;
-    lengthRemaining -= length;
 
-    length = loc_nmea_put_checksum(sentence, bufSize);
+    return w.finish();
 }
 
 /*===========================================================================
@@ -1257,6 +1497,52 @@ static void loc_nmea_get_fix_quality(const UlpLocation & location,
              ggaGpsQuality, rmcModeIndicator, vtgModeIndicator);
 }
 
+/* ddmm.mmmmmm,N,dddmm.mmmmmm,E, of the position as in RMC, GNS and GGA */
+static void loc_nmea_put_lat_long(LocNmeaWriter& w, const LocLla &ref_lla)
+{
+    double latitude = ref_lla.lat;
+    double longitude = ref_lla.lon;
+    char latHemisphere;
+    char lonHemisphere;
+    double latMinutes;
+    double lonMinutes;
+
+    if (latitude > 0)
+    {
+        latHemisphere = 'N';
+    }
+    else
+    {
+        latHemisphere = 'S';
+        latitude *= -1.0;
+    }
+
+    if (longitude < 0)
+    {
+        lonHemisphere = 'W';
+        longitude *= -1.0;
+    }
+    else
+    {
+        lonHemisphere = 'E';
+    }
+
+    latMinutes = fmod(latitude * 60.0 , 60.0);
+    lonMinutes = fmod(longitude * 60.0 , 60.0);
+
+    w.num((uint8_t)floor(latitude), 2).fixed(latMinutes, 6, 2).chr(',')
+     .chr(latHemisphere).chr(',')
+     .num((uint8_t)floor(longitude), 3).fixed(lonMinutes, 6, 2).chr(',')
+     .chr(lonHemisphere).chr(',');
+}
+
+/* hhmmss.ss */
+static void loc_nmea_put_utc_time(LocNmeaWriter& w, int utcHours, int utcMinutes,
+                                  int utcSeconds, int utcMSeconds)
+{
+    w.num(utcHours, 2).num(utcMinutes, 2).num(utcSeconds, 2).chr('.').num(utcMSeconds/10, 2);
+}
+
 /*===========================================================================
 FUNCTION    loc_nmea_generate_pos
 
@@ -1270,6 +1556,8 @@ DESCRIPTION
    - $--VTG : Track made good and ground speed
    - $--RMC : Recommended minimum navigation information
    - $--GGA : Time, position and fix related data
+   All the sentences go back to back into the buffer of nmea, without any
+   heap allocation.
 
 DEPENDENCIES
    NONE
@@ -1286,12 +1574,11 @@ void loc_nmea_generate_pos(const UlpLocation &location,
                                const LocationSystemInfo &systemInfo,
                                unsigned char generate_nmea,
                                bool custom_gga_fix_quality,
-                               std::vector<std::string> &nmeaArraystr,
-                               int& indexOfGGA)
+                               LocNmeaEpoch &nmea)
 {
     ENTRY_LOG();
 
-    indexOfGGA = -1;
+    nmea.indexOfGGA = -1;
     LocGpsUtcTime utcPosTimestamp = 0;
     bool inLsTransition = false;
 
@@ -1311,9 +1598,11 @@ void loc_nmea_generate_pos(const UlpLocation &location,
     char sentence_RMC[NMEA_SENTENCE_MAX_LENGTH] = {0};
     char sentence_GNS[NMEA_SENTENCE_MAX_LENGTH] = {0};
     char sentence_GGA[NMEA_SENTENCE_MAX_LENGTH] = {0};
-    char* pMarker = sentence;
-    int lengthRemaining = sizeof(sentence);
     int length = 0;
+    int length_DTM = 0;
+    int length_RMC = 0;
+    int length_GNS = 0;
+    int length_GGA = 0;
     int utcYear = pTm->tm_year % 100; // 2 digit year
     int utcMonth = pTm->tm_mon + 1; // tm_mon starts at zero
     int utcDay = pTm->tm_mday;
@@ -1368,7 +1657,7 @@ void loc_nmea_generate_pos(const UlpLocation &location,
 
         count = loc_nmea_generate_GSA(locationExtended, sentence, sizeof(sentence),
                         loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GPS,
-                        GNSS_SIGNAL_GPS_L1CA, true), nmeaArraystr);
+                        GNSS_SIGNAL_GPS_L1CA, true), nmea);
         if (count > 0)
         {
             svUsedCount += count;
@@ -1382,7 +1671,7 @@ void loc_nmea_generate_pos(const UlpLocation &location,
 
         count = loc_nmea_generate_GSA(locationExtended, sentence, sizeof(sentence),
                         loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GLONASS,
-                        GNSS_SIGNAL_GLONASS_G1, true), nmeaArraystr);
+                        GNSS_SIGNAL_GLONASS_G1, true), nmea);
         if (count > 0)
         {
             svUsedCount += count;
@@ -1396,7 +1685,7 @@ void loc_nmea_generate_pos(const UlpLocation &location,
 
         count = loc_nmea_generate_GSA(locationExtended, sentence, sizeof(sentence),
                         loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GALILEO,
-                        GNSS_SIGNAL_GALILEO_E1, true), nmeaArraystr);
+                        GNSS_SIGNAL_GALILEO_E1, true), nmea);
         if (count > 0)
         {
             svUsedCount += count;
@@ -1409,7 +1698,7 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         // ----------------------------
         count = loc_nmea_generate_GSA(locationExtended, sentence, sizeof(sentence),
                         loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_BEIDOU,
-                        GNSS_SIGNAL_BEIDOU_B1I, true), nmeaArraystr);
+                        GNSS_SIGNAL_BEIDOU_B1I, true), nmea);
         if (count > 0)
         {
             svUsedCount += count;
@@ -1423,7 +1712,7 @@ void loc_nmea_generate_pos(const UlpLocation &location,
 
         count = loc_nmea_generate_GSA(locationExtended, sentence, sizeof(sentence),
                         loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_QZSS,
-                        GNSS_SIGNAL_QZSS_L1CA, true), nmeaArraystr);
+                        GNSS_SIGNAL_QZSS_L1CA, true), nmea);
         if (count > 0)
         {
             svUsedCount += count;
@@ -1436,7 +1725,7 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         if (svUsedCount == 0) {
             strlcpy(sentence, "$GPGSA,A,1,,,,,,,,,,,,,,,,", sizeof(sentence));
             length = loc_nmea_put_checksum(sentence, sizeof(sentence));
-            nmeaArraystr.push_back(sentence);
+            loc_nmea_epoch_append(nmea, sentence, length);
         }
 
         char ggaGpsQuality[3] = {'0', '\0', '\0'};
@@ -1450,8 +1739,7 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         // ------$--VTG-------
         // -------------------
 
-        pMarker = sentence;
-        lengthRemaining = sizeof(sentence);
+        LocNmeaWriter vtg(sentence, sizeof(sentence));
 
         if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_BEARING)
         {
@@ -1465,45 +1753,34 @@ void loc_nmea_generate_pos(const UlpLocation &location,
                     magTrack -= 360.0;
             }
 
-            length = snprintf(pMarker, lengthRemaining, "$%sVTG,%.1lf,T,%.1lf,M,", talker, location.gpsLocation.bearing, magTrack);
+            vtg.chr('$').str(talker).str("VTG,").fixed(location.gpsLocation.bearing, 1)
+               .str(",T,").fixed(magTrack, 1).str(",M,");
         }
         else
         {
-            length = snprintf(pMarker, lengthRemaining, "$%sVTG,,T,,M,", talker);
+            vtg.chr('$').str(talker).str("VTG,,T,,M,");
         }
 
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
-
         if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_SPEED)
         {
             float speedKnots = location.gpsLocation.speed * (3600.0/1852.0);
             float speedKmPerHour = location.gpsLocation.speed * 3.6;
 
-            length = snprintf(pMarker, lengthRemaining, "%.1lf,N,%.1lf,K,", speedKnots, speedKmPerHour);
+            vtg.fixed(speedKnots, 1).str(",N,").fixed(speedKmPerHour, 1).str(",K,");
         }
         else
         {
-            length = snprintf(pMarker, lengthRemaining, ",N,,K,");
+            vtg.str(",N,,K,");
         }
 
-        if (length < 0 || length >= lengthRemaining)
+        vtg.chr(vtgModeIndicator);
+
+        if (!vtg.ok())
         {
             LOC_LOGE("NMEA Error in string formatting");
             return;
         }
-        pMarker += length;
-        lengthRemaining -= length;
-
-        length = snprintf(pMarker, lengthRemaining, "%c", vtgModeIndicator);
-
-        length = loc_nmea_put_checksum(sentence, sizeof(sentence));
-        nmeaArraystr.push_back(sentence);
+        loc_nmea_epoch_append(nmea, sentence, vtg.finish());
 
         memset(&ecef_w84, 0, sizeof(ecef_w84));
         memset(&ecef_p90, 0, sizeof(ecef_p90));
@@ -1543,14 +1820,14 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         // -------------------
         // ------$--DTM-------
         // -------------------
-        loc_nmea_generate_DTM(ref_lla, local_lla, talker, sentence_DTM, sizeof(sentence_DTM));
+        length_DTM = loc_nmea_generate_DTM(ref_lla, local_lla, talker,
+                                           sentence_DTM, sizeof(sentence_DTM));
 
         // -------------------
         // ------$--RMC-------
         // -------------------
 
-        pMarker = sentence_RMC;
-        lengthRemaining = sizeof(sentence_RMC);
+        LocNmeaWriter rmc(sentence_RMC, sizeof(sentence_RMC));
 
         bool validFix = ((0 != sv_cache_info.gps_used_mask) ||
                 (0 != sv_cache_info.glo_used_mask) ||
@@ -1558,116 +1835,39 @@ void loc_nmea_generate_pos(const UlpLocation &location,
                 (0 != sv_cache_info.qzss_used_mask) ||
                 (0 != sv_cache_info.bds_used_mask));
 
-        if (validFix) {
-            length = snprintf(pMarker, lengthRemaining, "$%sRMC,%02d%02d%02d.%02d,A,",
-                              talker, utcHours, utcMinutes, utcSeconds, utcMSeconds/10);
-        } else {
-            length = snprintf(pMarker, lengthRemaining, "$%sRMC,%02d%02d%02d.%02d,V,",
-                              talker, utcHours, utcMinutes, utcSeconds, utcMSeconds/10);
-        }
-
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
+        rmc.chr('$').str(talker).str("RMC,");
+        loc_nmea_put_utc_time(rmc, utcHours, utcMinutes, utcSeconds, utcMSeconds);
+        rmc.str(validFix ? ",A," : ",V,");
 
         if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_LAT_LONG)
         {
-            double latitude = ref_lla.lat;
-            double longitude = ref_lla.lon;
-            char latHemisphere;
-            char lonHemisphere;
-            double latMinutes;
-            double lonMinutes;
-
-            if (latitude > 0)
-            {
-                latHemisphere = 'N';
-            }
-            else
-            {
-                latHemisphere = 'S';
-                latitude *= -1.0;
-            }
-
-            if (longitude < 0)
-            {
-                lonHemisphere = 'W';
-                longitude *= -1.0;
-            }
-            else
-            {
-                lonHemisphere = 'E';
-            }
-
-            latMinutes = fmod(latitude * 60.0 , 60.0);
-            lonMinutes = fmod(longitude * 60.0 , 60.0);
-
-            length = snprintf(pMarker, lengthRemaining, "%02d%09.6lf,%c,%03d%09.6lf,%c,",
-                              (uint8_t)floor(latitude), latMinutes, latHemisphere,
-                              (uint8_t)floor(longitude),lonMinutes, lonHemisphere);
+            loc_nmea_put_lat_long(rmc, ref_lla);
         }
         else
         {
-            length = snprintf(pMarker, lengthRemaining,",,,,");
-        }
-
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
+            rmc.str(",,,,");
         }
-        pMarker += length;
-        lengthRemaining -= length;
 
         if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_SPEED)
         {
             float speedKnots = location.gpsLocation.speed * (3600.0/1852.0);
-            length = snprintf(pMarker, lengthRemaining, "%.1lf,", speedKnots);
+            rmc.fixed(speedKnots, 1).chr(',');
         }
         else
         {
-            length = snprintf(pMarker, lengthRemaining, ",");
+            rmc.chr(',');
         }
 
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
-
         if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_BEARING)
         {
-            length = snprintf(pMarker, lengthRemaining, "%.1lf,", location.gpsLocation.bearing);
+            rmc.fixed(location.gpsLocation.bearing, 1).chr(',');
         }
         else
         {
-            length = snprintf(pMarker, lengthRemaining, ",");
+            rmc.chr(',');
         }
 
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
-
-        length = snprintf(pMarker, lengthRemaining, "%2.2d%2.2d%2.2d,",
-                          utcDay, utcMonth, utcYear);
-
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
+        rmc.num(utcDay, 2).num(utcMonth, 2).num(utcYear, 2).chr(',');
 
         if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_MAG_DEV)
         {
@@ -1683,405 +1883,254 @@ void loc_nmea_generate_pos(const UlpLocation &location,
                 direction = 'E';
             }
 
-            length = snprintf(pMarker, lengthRemaining, "%.1lf,%c,",
-                              magneticVariation, direction);
+            rmc.fixed(magneticVariation, 1).chr(',').chr(direction).chr(',');
         }
         else
         {
-            length = snprintf(pMarker, lengthRemaining, ",,");
+            rmc.str(",,");
         }
 
-        if (length < 0 || length >= lengthRemaining)
+        rmc.chr(rmcModeIndicator);
+
+        // hardcode Navigation Status field to 'V'
+        rmc.str(",V");
+
+        if (!rmc.ok())
         {
             LOC_LOGE("NMEA Error in string formatting");
             return;
         }
-        pMarker += length;
-        lengthRemaining -= length;
-
-        length = snprintf(pMarker, lengthRemaining, "%c", rmcModeIndicator);
-        pMarker += length;
-        lengthRemaining -= length;
-
-        // hardcode Navigation Status field to 'V'
-        length = snprintf(pMarker, lengthRemaining, ",%c", 'V');
-
-        length = loc_nmea_put_checksum(sentence_RMC, sizeof(sentence_RMC));
+        length_RMC = rmc.finish();
 
         // -------------------
         // ------$--GNS-------
         // -------------------
 
-        pMarker = sentence_GNS;
-        lengthRemaining = sizeof(sentence_GNS);
-
-        length = snprintf(pMarker, lengthRemaining, "$%sGNS,%02d%02d%02d.%02d," ,
-                          talker, utcHours, utcMinutes, utcSeconds, utcMSeconds/10);
+        LocNmeaWriter gns(sentence_GNS, sizeof(sentence_GNS));
 
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
+        gns.chr('$').str(talker).str("GNS,");
+        loc_nmea_put_utc_time(gns, utcHours, utcMinutes, utcSeconds, utcMSeconds);
+        gns.chr(',');
 
         if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_LAT_LONG)
         {
-            double latitude = ref_lla.lat;
-            double longitude = ref_lla.lon;
-            char latHemisphere;
-            char lonHemisphere;
-            double latMinutes;
-            double lonMinutes;
-
-            if (latitude > 0)
-            {
-                latHemisphere = 'N';
-            }
-            else
-            {
-                latHemisphere = 'S';
-                latitude *= -1.0;
-            }
-
-            if (longitude < 0)
-            {
-                lonHemisphere = 'W';
-                longitude *= -1.0;
-            }
-            else
-            {
-                lonHemisphere = 'E';
-            }
-
-            latMinutes = fmod(latitude * 60.0 , 60.0);
-            lonMinutes = fmod(longitude * 60.0 , 60.0);
-
-            length = snprintf(pMarker, lengthRemaining, "%02d%09.6lf,%c,%03d%09.6lf,%c,",
-                              (uint8_t)floor(latitude), latMinutes, latHemisphere,
-                              (uint8_t)floor(longitude),lonMinutes, lonHemisphere);
+            loc_nmea_put_lat_long(gns, ref_lla);
         }
         else
         {
-            length = snprintf(pMarker, lengthRemaining,",,,,");
-        }
-
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
+            gns.str(",,,,");
         }
-        pMarker += length;
-        lengthRemaining -= length;
-
-        length = snprintf(pMarker, lengthRemaining, "%s,", gnsModeIndicator);
 
-        pMarker += length;
-        lengthRemaining -= length;
+        gns.str(gnsModeIndicator).chr(',');
 
         if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_DOP) {
-            length = snprintf(pMarker, lengthRemaining, "%02d,%.1f,",
-                              svUsedCount, locationExtended.hdop);
+            gns.num(svUsedCount, 2).chr(',').fixed(locationExtended.hdop, 1).chr(',');
         }
         else {   // no hdop
-            length = snprintf(pMarker, lengthRemaining, "%02d,,",
-                              svUsedCount);
-        }
-
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
+            gns.num(svUsedCount, 2).str(",,");
         }
-        pMarker += length;
-        lengthRemaining -= length;
 
         if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_ALTITUDE_MEAN_SEA_LEVEL)
         {
-            length = snprintf(pMarker, lengthRemaining, "%.1lf,",
-                              locationExtended.altitudeMeanSeaLevel);
+            gns.fixed(locationExtended.altitudeMeanSeaLevel, 1).chr(',');
         }
         else
         {
-            length = snprintf(pMarker, lengthRemaining,",");
+            gns.chr(',');
         }
 
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
-
         if ((location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_ALTITUDE) &&
             (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_ALTITUDE_MEAN_SEA_LEVEL))
         {
-            length = snprintf(pMarker, lengthRemaining, "%.1lf,",
-                              ref_lla.alt - locationExtended.altitudeMeanSeaLevel);
+            gns.fixed(ref_lla.alt - locationExtended.altitudeMeanSeaLevel, 1).chr(',');
         }
         else
         {
-            length = snprintf(pMarker, lengthRemaining, ",");
-        }
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
+            gns.chr(',');
         }
-        pMarker += length;
-        lengthRemaining -= length;
 
         if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_DGNSS_DATA_AGE)
         {
-            length = snprintf(pMarker, lengthRemaining, "%.1f,",
-                              (float)locationExtended.dgnssDataAgeMsec / 1000);
+            gns.fixed((float)locationExtended.dgnssDataAgeMsec / 1000, 1).chr(',');
         }
         else
         {
-            length = snprintf(pMarker, lengthRemaining, ",");
+            gns.chr(',');
         }
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
 
         if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_DGNSS_REF_STATION_ID)
         {
-            length = snprintf(pMarker, lengthRemaining, "%04d",
-                              locationExtended.dgnssRefStationId);
-            if (length < 0 || length >= lengthRemaining)
-            {
-                LOC_LOGE("NMEA Error in string formatting");
-                return;
-            }
-            pMarker += length;
-            lengthRemaining -= length;
+            gns.num(locationExtended.dgnssRefStationId, 4);
         }
 
         // hardcode Navigation Status field to 'V'
-        length = snprintf(pMarker, lengthRemaining, ",%c", 'V');
-        pMarker += length;
-        lengthRemaining -= length;
+        gns.str(",V");
 
-        length = loc_nmea_put_checksum(sentence_GNS, sizeof(sentence_GNS));
+        if (!gns.ok())
+        {
+            LOC_LOGE("NMEA Error in string formatting");
+            return;
+        }
+        length_GNS = gns.finish();
 
         // -------------------
         // ------$--GGA-------
         // -------------------
 
-        pMarker = sentence_GGA;
-        lengthRemaining = sizeof(sentence_GGA);
+        LocNmeaWriter gga(sentence_GGA, sizeof(sentence_GGA));
 
-        length = snprintf(pMarker, lengthRemaining, "$%sGGA,%02d%02d%02d.%02d," ,
-                          talker, utcHours, utcMinutes, utcSeconds, utcMSeconds/10);
-
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
+        gga.chr('$').str(talker).str("GGA,");
+        loc_nmea_put_utc_time(gga, utcHours, utcMinutes, utcSeconds, utcMSeconds);
+        gga.chr(',');
 
         if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_LAT_LONG)
         {
-            double latitude = ref_lla.lat;
-            double longitude = ref_lla.lon;
-            char latHemisphere;
-            char lonHemisphere;
-            double latMinutes;
-            double lonMinutes;
-
-            if (latitude > 0)
-            {
-                latHemisphere = 'N';
-            }
-            else
-            {
-                latHemisphere = 'S';
-                latitude *= -1.0;
-            }
-
-            if (longitude < 0)
-            {
-                lonHemisphere = 'W';
-                longitude *= -1.0;
-            }
-            else
-            {
-                lonHemisphere = 'E';
-            }
-
-            latMinutes = fmod(latitude * 60.0 , 60.0);
-            lonMinutes = fmod(longitude * 60.0 , 60.0);
-
-            length = snprintf(pMarker, lengthRemaining, "%02d%09.6lf,%c,%03d%09.6lf,%c,",
-                              (uint8_t)floor(latitude), latMinutes, latHemisphere,
-                              (uint8_t)floor(longitude),lonMinutes, lonHemisphere);
+            loc_nmea_put_lat_long(gga, ref_lla);
         }
         else
         {
-            length = snprintf(pMarker, lengthRemaining,",,,,");
+            gga.str(",,,,");
         }
 
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
-
         // Number of satellites in use, 00-12
         if (svUsedCount > MAX_SATELLITES_IN_USE)
             svUsedCount = MAX_SATELLITES_IN_USE;
         if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_DOP)
         {
-            length = snprintf(pMarker, lengthRemaining, "%s,%02d,%.1f,",
-                              ggaGpsQuality, svUsedCount, locationExtended.hdop);
+            gga.str(ggaGpsQuality).chr(',').num(svUsedCount, 2).chr(',')
+               .fixed(locationExtended.hdop, 1).chr(',');
         }
         else
         {   // no hdop
-            length = snprintf(pMarker, lengthRemaining, "%s,%02d,,",
-                              ggaGpsQuality, svUsedCount);
-        }
-
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
+            gga.str(ggaGpsQuality).chr(',').num(svUsedCount, 2).str(",,");
         }
-        pMarker += length;
-        lengthRemaining -= length;
 
         if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_ALTITUDE_MEAN_SEA_LEVEL)
         {
-            length = snprintf(pMarker, lengthRemaining, "%.1lf,M,",
-                              locationExtended.altitudeMeanSeaLevel);
+            gga.fixed(locationExtended.altitudeMeanSeaLevel, 1).str(",M,");
         }
         else
         {
-            length = snprintf(pMarker, lengthRemaining,",,");
-        }
-
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
+            gga.str(",,");
         }
-        pMarker += length;
-        lengthRemaining -= length;
 
         if ((location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_ALTITUDE) &&
             (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_ALTITUDE_MEAN_SEA_LEVEL))
         {
-            length = snprintf(pMarker, lengthRemaining, "%.1lf,M,",
-                              ref_lla.alt - locationExtended.altitudeMeanSeaLevel);
+            gga.fixed(ref_lla.alt - locationExtended.altitudeMeanSeaLevel, 1).str(",M,");
         }
         else
         {
-            length = snprintf(pMarker, lengthRemaining, ",,");
+            gga.str(",,");
         }
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
 
         if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_DGNSS_DATA_AGE)
         {
-            length = snprintf(pMarker, lengthRemaining, "%.1f,",
-                              (float)locationExtended.dgnssDataAgeMsec / 1000);
+            gga.fixed((float)locationExtended.dgnssDataAgeMsec / 1000, 1).chr(',');
         }
         else
         {
-            length = snprintf(pMarker, lengthRemaining, ",");
-        }
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
+            gga.chr(',');
         }
-        pMarker += length;
-        lengthRemaining -= length;
 
         if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_DGNSS_REF_STATION_ID)
         {
-            length = snprintf(pMarker, lengthRemaining, "%04d",
-                              locationExtended.dgnssRefStationId);
-            if (length < 0 || length >= lengthRemaining)
-            {
-                LOC_LOGE("NMEA Error in string formatting");
-                return;
-            }
-            pMarker += length;
-            lengthRemaining -= length;
+            gga.num(locationExtended.dgnssRefStationId, 4);
         }
 
-        length = loc_nmea_put_checksum(sentence_GGA, sizeof(sentence_GGA));
+        if (!gga.ok())
+        {
+            LOC_LOGE("NMEA Error in string formatting");
+            return;
+        }
+        length_GGA = gga.finish();
 
         // ------$--DTM-------
-        nmeaArraystr.push_back(sentence_DTM);
+        loc_nmea_epoch_append(nmea, sentence_DTM, length_DTM);
         // ------$--RMC-------
-        nmeaArraystr.push_back(sentence_RMC);
+        loc_nmea_epoch_append(nmea, sentence_RMC, length_RMC);
         if(LOC_GNSS_DATUM_PZ90 == datum_type) {
             // ------$--DTM-------
-            nmeaArraystr.push_back(sentence_DTM);
+            loc_nmea_epoch_append(nmea, sentence_DTM, length_DTM);
         }
         // ------$--GNS-------
-        nmeaArraystr.push_back(sentence_GNS);
+        loc_nmea_epoch_append(nmea, sentence_GNS, length_GNS);
         if(LOC_GNSS_DATUM_PZ90 == datum_type) {
             // ------$--DTM-------
-            nmeaArraystr.push_back(sentence_DTM);
+            loc_nmea_epoch_append(nmea, sentence_DTM, length_DTM);
         }
         // ------$--GGA-------
-        nmeaArraystr.push_back(sentence_GGA);
-        indexOfGGA = static_cast<int>(nmeaArraystr.size() - 1);
+        uint32_t count_before_GGA = nmea.count;
+        loc_nmea_epoch_append(nmea, sentence_GGA, length_GGA);
+        if (nmea.count > count_before_GGA) {
+            nmea.indexOfGGA = static_cast<int>(count_before_GGA);
+        }
     }
     //Send blank NMEA reports for non-final fixes
     else {
         strlcpy(sentence, "$GPGSA,A,1,,,,,,,,,,,,,,,,", sizeof(sentence));
         length = loc_nmea_put_checksum(sentence, sizeof(sentence));
-        nmeaArraystr.push_back(sentence);
+        loc_nmea_epoch_append(nmea, sentence, length);
 
         strlcpy(sentence, "$GPVTG,,T,,M,,N,,K,N", sizeof(sentence));
         length = loc_nmea_put_checksum(sentence, sizeof(sentence));
-        nmeaArraystr.push_back(sentence);
+        loc_nmea_epoch_append(nmea, sentence, length);
 
         strlcpy(sentence, "$GPDTM,,,,,,,,", sizeof(sentence));
         length = loc_nmea_put_checksum(sentence, sizeof(sentence));
-        nmeaArraystr.push_back(sentence);
+        loc_nmea_epoch_append(nmea, sentence, length);
 
         strlcpy(sentence, "$GPRMC,,V,,,,,,,,,,N,V", sizeof(sentence));
         length = loc_nmea_put_checksum(sentence, sizeof(sentence));
-        nmeaArraystr.push_back(sentence);
+        loc_nmea_epoch_append(nmea, sentence, length);
 
         strlcpy(sentence, "$GPGNS,,,,,,N,,,,,,,V", sizeof(sentence));
         length = loc_nmea_put_checksum(sentence, sizeof(sentence));
-        nmeaArraystr.push_back(sentence);
+        loc_nmea_epoch_append(nmea, sentence, length);
 
         strlcpy(sentence, "$GPGGA,,,,,,0,,,,,,,,", sizeof(sentence));
         length = loc_nmea_put_checksum(sentence, sizeof(sentence));
-        nmeaArraystr.push_back(sentence);
+        loc_nmea_epoch_append(nmea, sentence, length);
     }
 
     EXIT_LOG(%d, 0);
 }
 
+/* splits the sentences of an epoch into strings */
+static void loc_nmea_epoch_to_strings(const LocNmeaEpoch &nmea,
+                                      std::vector<std::string> &nmeaArraystr)
+{
+    for (uint32_t i = 0; i < nmea.count; i++) {
+        nmeaArraystr.push_back(std::string(nmea.buf + nmea.offsets[i],
+                                           loc_nmea_epoch_sentence_length(nmea, i)));
+    }
+}
+
+void loc_nmea_generate_pos(const UlpLocation &location,
+                               const GpsLocationExtended &locationExtended,
+                               const LocationSystemInfo &systemInfo,
+                               unsigned char generate_nmea,
+                               bool custom_gga_fix_quality,
+                               std::vector<std::string> &nmeaArraystr,
+                               int& indexOfGGA)
+{
+    std::vector<char> buf(NMEA_EPOCH_MAX_LENGTH);
+    LocNmeaEpoch nmea;
+    loc_nmea_epoch_init(nmea, buf.data(), buf.size());
+    loc_nmea_generate_pos(location, locationExtended, systemInfo, generate_nmea,
+                          custom_gga_fix_quality, nmea);
+    indexOfGGA = (-1 == nmea.indexOfGGA) ? -1 : (int)nmeaArraystr.size() + nmea.indexOfGGA;
+    loc_nmea_epoch_to_strings(nmea, nmeaArraystr);
+}
+
 
 
 /*===========================================================================
 FUNCTION    loc_nmea_generate_sv
 
 DESCRIPTION
-   Generate NMEA sentences generated based on sv report
+   Generate NMEA sentences generated based on sv report, back to back
+   into the buffer of nmea
 
 DEPENDENCIES
    NONE
@@ -2094,7 +2143,7 @@ SIDE EFFECTS
 
 ===========================================================================*/
 void loc_nmea_generate_sv(const GnssSvNotification &svNotify,
-                              std::vector<std::string> &nmeaArraystr)
+                              LocNmeaEpoch &nmea)
 {
     ENTRY_LOG();
 
@@ -2176,7 +2225,7 @@ void loc_nmea_generate_sv(const GnssSvNotification &svNotify,
 
     loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
             loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GPS,
-            GNSS_SIGNAL_GPS_L1CA, false), nmeaArraystr);
+            GNSS_SIGNAL_GPS_L1CA, false), nmea);
 
     // ---------------------
     // ------$GPGSV:L5------
@@ -2184,14 +2233,14 @@ void loc_nmea_generate_sv(const GnssSvNotification &svNotify,
 
     loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
             loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GPS,
-            GNSS_SIGNAL_GPS_L5, false), nmeaArraystr);
+            GNSS_SIGNAL_GPS_L5, false), nmea);
 
     // ---------------------
     // ------$GPGSV:L2------
     // ---------------------
     loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
             loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GPS,
-            GNSS_SIGNAL_GPS_L2, false), nmeaArraystr);
+            GNSS_SIGNAL_GPS_L2, false), nmea);
 
     // ---------------------
     // ------$GLGSV:G1------
@@ -2199,7 +2248,7 @@ void loc_nmea_generate_sv(const GnssSvNotification &svNotify,
 
     loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
             loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GLONASS,
-            GNSS_SIGNAL_GLONASS_G1, false), nmeaArraystr);
+            GNSS_SIGNAL_GLONASS_G1, false), nmea);
 
     // ---------------------
     // ------$GLGSV:G2------
@@ -2207,7 +2256,7 @@ void loc_nmea_generate_sv(const GnssSvNotification &svNotify,
 
     loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
             loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GLONASS,
-            GNSS_SIGNAL_GLONASS_G2, false), nmeaArraystr);
+            GNSS_SIGNAL_GLONASS_G2, false), nmea);
 
     // ---------------------
     // ------$GAGSV:E1------
@@ -2215,21 +2264,21 @@ void loc_nmea_generate_sv(const GnssSvNotification &svNotify,
 
     loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
             loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GALILEO,
-            GNSS_SIGNAL_GALILEO_E1, false), nmeaArraystr);
+            GNSS_SIGNAL_GALILEO_E1, false), nmea);
 
     // -------------------------
     // ------$GAGSV:E5A---------
     // -------------------------
     loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
             loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GALILEO,
-            GNSS_SIGNAL_GALILEO_E5A, false), nmeaArraystr);
+            GNSS_SIGNAL_GALILEO_E5A, false), nmea);
 
     // -------------------------
     // ------$GAGSV:E5B---------
     // -------------------------
     loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
             loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_GALILEO,
-            GNSS_SIGNAL_GALILEO_E5B, false), nmeaArraystr);
+            GNSS_SIGNAL_GALILEO_E5B, false), nmea);
 
     // -----------------------------
     // ------$GQGSV (QZSS):L1CA-----
@@ -2237,7 +2286,7 @@ void loc_nmea_generate_sv(const GnssSvNotification &svNotify,
 
     loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
             loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_QZSS,
-            GNSS_SIGNAL_QZSS_L1CA, false), nmeaArraystr);
+            GNSS_SIGNAL_QZSS_L1CA, false), nmea);
 
     // -----------------------------
     // ------$GQGSV (QZSS):L5-------
@@ -2245,7 +2294,7 @@ void loc_nmea_generate_sv(const GnssSvNotification &svNotify,
 
     loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
             loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_QZSS,
-            GNSS_SIGNAL_QZSS_L5, false), nmeaArraystr);
+            GNSS_SIGNAL_QZSS_L5, false), nmea);
 
     // -----------------------------
     // ------$GQGSV (QZSS):L2-------
@@ -2253,7 +2302,7 @@ void loc_nmea_generate_sv(const GnssSvNotification &svNotify,
 
     loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
             loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_QZSS,
-            GNSS_SIGNAL_QZSS_L2, false), nmeaArraystr);
+            GNSS_SIGNAL_QZSS_L2, false), nmea);
 
 
     // -----------------------------
@@ -2262,14 +2311,14 @@ void loc_nmea_generate_sv(const GnssSvNotification &svNotify,
 
     loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
             loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_BEIDOU,
-            GNSS_SIGNAL_BEIDOU_B1I, false), nmeaArraystr);
+            GNSS_SIGNAL_BEIDOU_B1I, false), nmea);
 
     // -----------------------------
     // ------$GBGSV (BEIDOU:B1C)----
     // -----------------------------
     loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
             loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_BEIDOU,
-            GNSS_SIGNAL_BEIDOU_B1C, false), nmeaArraystr);
+            GNSS_SIGNAL_BEIDOU_B1C, false), nmea);
 
     // -----------------------------
     // ------$GBGSV (BEIDOU:B2AI)---
@@ -2277,7 +2326,7 @@ void loc_nmea_generate_sv(const GnssSvNotification &svNotify,
 
     loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
             loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_BEIDOU,
-            GNSS_SIGNAL_BEIDOU_B2AI, false), nmeaArraystr);
+            GNSS_SIGNAL_BEIDOU_B2AI, false), nmea);
 
     // -----------------------------
     // ------$GIGSV (NAVIC:L5)------
@@ -2285,7 +2334,41 @@ void loc_nmea_generate_sv(const GnssSvNotification &svNotify,
 
     loc_nmea_generate_GSV(svNotify, sentence, sizeof(sentence),
             loc_nmea_sv_meta_init(sv_meta, sv_cache_info, GNSS_SV_TYPE_NAVIC,
-            GNSS_SIGNAL_NAVIC_L5,false), nmeaArraystr);
+            GNSS_SIGNAL_NAVIC_L5,false), nmea);
 
     EXIT_LOG(%d, 0);
 }
+
+void loc_nmea_generate_sv(const GnssSvNotification &svNotify,
+                              std::vector<std::string> &nmeaArraystr)
+{
+    std::vector<char> buf(NMEA_EPOCH_MAX_LENGTH);
+    LocNmeaEpoch nmea;
+    loc_nmea_epoch_init(nmea, buf.data(), buf.size());
+    loc_nmea_generate_sv(svNotify, nmea);
+    loc_nmea_epoch_to_strings(nmea, nmeaArraystr);
+}
+
+/*===========================================================================
+FUNCTION    loc_nmea_get_gsv_cache_stats
+
+DESCRIPTION
+   Number of GSV pages reused from the previous report and number of pages
+   rendered again since start
+
+DEPENDENCIES
+   NONE
+
+RETURN VALUE
+   NONE
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+void loc_nmea_get_gsv_cache_stats(uint64_t &hits, uint64_t &misses)
+{
+    std::lock_guard<std::mutex> guard(sGsvCacheLock);
+    hits = sGsvCacheHits;
+    misses = sGsvCacheMisses;
+}
@@ -33,7 +33,10 @@
 #include <gps_extended.h>
 #include <vector>
 #include <string>
+#include <string.h>
 #define NMEA_SENTENCE_MAX_LENGTH 200
+#define NMEA_EPOCH_MAX_SENTENCES 64
+#define NMEA_EPOCH_MAX_LENGTH (NMEA_EPOCH_MAX_SENTENCES * NMEA_SENTENCE_MAX_LENGTH)
 
 /** gnss datum type */
 #define LOC_GNSS_DATUM_WGS84          0
@@ -72,9 +75,48 @@ typedef struct {
     double     Z;
 } LocEcef;
 
+/** Sentences of one epoch, back to back in a caller owned buffer */
+typedef struct {
+    char*      buf;
+    uint32_t   size;
+    uint32_t   length;
+    uint32_t   count;
+    uint32_t   offsets[NMEA_EPOCH_MAX_SENTENCES];
+    int        indexOfGGA;
+} LocNmeaEpoch;
+
+inline void loc_nmea_epoch_init(LocNmeaEpoch &nmea, char* buf, uint32_t size) {
+    nmea.buf = buf;
+    nmea.size = size;
+    nmea.length = 0;
+    nmea.count = 0;
+    nmea.indexOfGGA = -1;
+    if (size > 0) {
+        buf[0] = '\0';
+    }
+}
+
+inline uint32_t loc_nmea_epoch_sentence_length(const LocNmeaEpoch &nmea, uint32_t i) {
+    return ((i + 1 < nmea.count) ? nmea.offsets[i + 1] : nmea.length) - nmea.offsets[i];
+}
+
+void loc_nmea_generate_sv(const GnssSvNotification &svNotify,
+                              LocNmeaEpoch &nmea);
+
+void loc_nmea_generate_pos(const UlpLocation &location,
+                               const GpsLocationExtended &locationExtended,
+                               const LocationSystemInfo &systemInfo,
+                               unsigned char generate_nmea,
+                               bool custom_gga_fix_quality,
+                               LocNmeaEpoch &nmea);
+
 void loc_nmea_generate_sv(const GnssSvNotification &svNotify,
                               std::vector<std::string> &nmeaArraystr);
 
+/* GSV pages are rendered again only when their SVs changed since the
+   previous report, this returns how many pages were reused and rendered */
+void loc_nmea_get_gsv_cache_stats(uint64_t &hits, uint64_t &misses);
+
 void loc_nmea_generate_pos(const UlpLocation &location,
                                const GpsLocationExtended &locationExtended,
                                const LocationSystemInfo &systemInfo,
@@ -90,5 +132,11 @@ inline bool loc_nmea_is_debug(const char* nmea, int length) {
             (length >= DEBUG_NMEA_MINSIZE) && (length <= DEBUG_NMEA_MAXSIZE) &&
             (nmea[0] == '$') && (nmea[1] == 'P') && (nmea[2] == 'Q') && (nmea[3] == 'W'));
 }
+/* the tag of a debug sentence, $PQWM1, $PQWP1..., packed into an integer */
+inline uint64_t loc_nmea_debug_tag(const char* nmea) {
+    uint64_t tag = 0;
+    memcpy(&tag, nmea, DEBUG_NMEA_MINSIZE);
+    return tag;
+}
 
 #endif // LOC_ENG_NMEA_H
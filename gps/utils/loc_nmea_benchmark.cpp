@@ -0,0 +1,197 @@
+/* Copyright (c) 2020 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/* Benchmark of the NMEA generation: the GSA/GSV/RMC/GGA/VTG sentences of an
+   epoch with 64 SVs across all the constellations, into a LocNmeaEpoch
+   buffer as the adapter does.
+
+   Usage: loc_nmea_benchmark [--benchmark_filter=<regex>] */
+
+#include <loc_nmea.h>
+#include <benchmark/benchmark.h>
+#include <string.h>
+
+namespace {
+
+struct Constellation {
+    GnssSvType mType;
+    uint16_t mFirstSvId;
+    uint32_t mCount;
+    GnssSignalTypeMask mSignals[2];
+};
+
+// 64 SVs, with two signals for the constellations that have them
+const Constellation sConstellations[] = {
+    {GNSS_SV_TYPE_GPS,      1, 12, {GNSS_SIGNAL_GPS_L1CA, GNSS_SIGNAL_GPS_L5}},
+    {GNSS_SV_TYPE_GLONASS, 65, 10, {GNSS_SIGNAL_GLONASS_G1, GNSS_SIGNAL_GLONASS_G2}},
+    {GNSS_SV_TYPE_GALILEO, 301, 12, {GNSS_SIGNAL_GALILEO_E1, GNSS_SIGNAL_GALILEO_E5A}},
+    {GNSS_SV_TYPE_BEIDOU, 201, 16, {GNSS_SIGNAL_BEIDOU_B1I, GNSS_SIGNAL_BEIDOU_B2AI}},
+    {GNSS_SV_TYPE_QZSS,   193,  4, {GNSS_SIGNAL_QZSS_L1CA, GNSS_SIGNAL_QZSS_L5}},
+    {GNSS_SV_TYPE_NAVIC,  401,  4, {GNSS_SIGNAL_NAVIC_L5, GNSS_SIGNAL_NAVIC_L5}},
+    {GNSS_SV_TYPE_SBAS,   120,  6, {GNSS_SIGNAL_SBAS_L1, GNSS_SIGNAL_SBAS_L1}},
+};
+
+void makeSvReport(GnssSvNotification& svNotify) {
+    memset(&svNotify, 0, sizeof(svNotify));
+    svNotify.size = sizeof(svNotify);
+    svNotify.gnssSignalTypeMaskValid = true;
+    for (auto& c : sConstellations) {
+        for (uint32_t i = 0; i < c.mCount; i++) {
+            GnssSv& sv = svNotify.gnssSvs[svNotify.count++];
+            sv.svId = c.mFirstSvId + i;
+            sv.type = c.mType;
+            sv.cN0Dbhz = 20.0f + (svNotify.count * 7) % 28;
+            sv.elevation = 5.0f + (svNotify.count * 13) % 85;
+            sv.azimuth = (svNotify.count * 37) % 360;
+            sv.gnssSvOptionsMask = GNSS_SV_OPTIONS_HAS_EPHEMER_BIT |
+                    GNSS_SV_OPTIONS_HAS_GNSS_SIGNAL_TYPE_BIT |
+                    ((i % 3) ? GNSS_SV_OPTIONS_USED_IN_FIX_BIT : 0);
+            sv.gnssSignalTypeMask = c.mSignals[i % 2];
+        }
+    }
+}
+
+void makePosition(UlpLocation& location, GpsLocationExtended& locationExtended) {
+    memset(&location, 0, sizeof(location));
+    memset(&locationExtended, 0, sizeof(locationExtended));
+    location.gpsLocation.flags = LOC_GPS_LOCATION_HAS_LAT_LONG | LOC_GPS_LOCATION_HAS_ALTITUDE |
+            LOC_GPS_LOCATION_HAS_SPEED | LOC_GPS_LOCATION_HAS_BEARING |
+            LOC_GPS_LOCATION_HAS_ACCURACY;
+    location.gpsLocation.latitude = 32.8973215;
+    location.gpsLocation.longitude = -117.2024628;
+    location.gpsLocation.altitude = 106.4;
+    location.gpsLocation.speed = 12.25;
+    location.gpsLocation.bearing = 271.5;
+    location.gpsLocation.accuracy = 3.2;
+    location.gpsLocation.timestamp = 1602950400123ULL;
+    locationExtended.flags = GPS_LOCATION_EXTENDED_HAS_DOP |
+            GPS_LOCATION_EXTENDED_HAS_ALTITUDE_MEAN_SEA_LEVEL |
+            GPS_LOCATION_EXTENDED_HAS_MAG_DEV | GPS_LOCATION_EXTENDED_HAS_NAV_SOLUTION_MASK |
+            GPS_LOCATION_EXTENDED_HAS_POS_TECH_MASK | GPS_LOCATION_EXTENDED_HAS_GPS_TIME;
+    locationExtended.pdop = 1.4;
+    locationExtended.hdop = 0.8;
+    locationExtended.vdop = 1.1;
+    locationExtended.altitudeMeanSeaLevel = 142.7;
+    locationExtended.magneticDeviation = 11.6;
+    locationExtended.tech_mask = LOC_POS_TECH_MASK_SATELLITE;
+    locationExtended.gpsTime.gpsWeek = 2127;
+    locationExtended.gpsTime.gpsTimeOfWeekMs = 432018000;
+    GnssSvUsedInPosition& used = locationExtended.gnss_sv_used_ids;
+    used.gps_sv_used_ids_mask = 0x0db6;
+    used.glo_sv_used_ids_mask = 0x036d;
+    used.gal_sv_used_ids_mask = 0x0db6;
+    used.bds_sv_used_ids_mask = 0xb6db;
+    used.qzss_sv_used_ids_mask = 0x6;
+    used.navic_sv_used_ids_mask = 0x6;
+}
+
+// SV reports whose signal strengths all change, so every GSV page is rendered
+void BM_NmeaSvChanging(benchmark::State& state) {
+    static GnssSvNotification svNotify;
+    makeSvReport(svNotify);
+    char buf[NMEA_EPOCH_MAX_LENGTH];
+    LocNmeaEpoch nmea;
+    uint32_t epoch = 0;
+    for (auto _ : state) {
+        epoch++;
+        for (uint32_t i = 0; i < svNotify.count; i++) {
+            svNotify.gnssSvs[i].cN0Dbhz = 20.0f + (i * 7 + epoch) % 28;
+        }
+        loc_nmea_epoch_init(nmea, buf, sizeof(buf));
+        loc_nmea_generate_sv(svNotify, nmea);
+        benchmark::DoNotOptimize(nmea.length);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_NmeaSvChanging);
+
+// the same SV report every epoch, as while the SVs are steady
+void BM_NmeaSvUnchanged(benchmark::State& state) {
+    static GnssSvNotification svNotify;
+    makeSvReport(svNotify);
+    char buf[NMEA_EPOCH_MAX_LENGTH];
+    LocNmeaEpoch nmea;
+    for (auto _ : state) {
+        loc_nmea_epoch_init(nmea, buf, sizeof(buf));
+        loc_nmea_generate_sv(svNotify, nmea);
+        benchmark::DoNotOptimize(nmea.length);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_NmeaSvUnchanged);
+
+// GSA, RMC, GGA and VTG of a position with SVs of all constellations used
+void BM_NmeaPosition(benchmark::State& state) {
+    UlpLocation location;
+    GpsLocationExtended locationExtended;
+    LocationSystemInfo systemInfo;
+    memset(&systemInfo, 0, sizeof(systemInfo));
+    makePosition(location, locationExtended);
+    char buf[NMEA_EPOCH_MAX_LENGTH];
+    LocNmeaEpoch nmea;
+    for (auto _ : state) {
+        location.gpsLocation.timestamp += 1000;
+        loc_nmea_epoch_init(nmea, buf, sizeof(buf));
+        loc_nmea_generate_pos(location, locationExtended, systemInfo, 1, false, nmea);
+        benchmark::DoNotOptimize(nmea.length);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_NmeaPosition);
+
+// a full epoch, SV report and position, through the std::string interface
+void BM_NmeaEpochStrings(benchmark::State& state) {
+    static GnssSvNotification svNotify;
+    makeSvReport(svNotify);
+    UlpLocation location;
+    GpsLocationExtended locationExtended;
+    LocationSystemInfo systemInfo;
+    memset(&systemInfo, 0, sizeof(systemInfo));
+    makePosition(location, locationExtended);
+    uint32_t epoch = 0;
+    for (auto _ : state) {
+        epoch++;
+        for (uint32_t i = 0; i < svNotify.count; i++) {
+            svNotify.gnssSvs[i].cN0Dbhz = 20.0f + (i * 7 + epoch) % 28;
+        }
+        location.gpsLocation.timestamp += 1000;
+        std::vector<std::string> sentences;
+        int indexOfGGA = -1;
+        loc_nmea_generate_sv(svNotify, sentences);
+        loc_nmea_generate_pos(location, locationExtended, systemInfo, 1, false,
+                              sentences, indexOfGGA);
+        benchmark::DoNotOptimize(sentences.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_NmeaEpochStrings);
+
+} // namespace
+
+BENCHMARK_MAIN();
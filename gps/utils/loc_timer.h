@@ -67,6 +67,14 @@ void* loc_timer_start(uint64_t delay_msec,
 */
 void loc_timer_stop(void*& handle);
 
+/*
+    slack_msec:         granularity by which timers started with
+                        wake_on_expire false may expire late, so that
+                        their expiries coalesce. 0 keeps them exact.
+                        Only effective before the first such timer starts.
+*/
+void loc_timer_set_slack(uint32_t slack_msec);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -96,6 +96,8 @@ typedef struct loc_logger_s
   unsigned long  DEBUG_LEVEL;
   unsigned long  TIMESTAMP;
   bool           LOG_BUFFER_ENABLE;
+  bool           LOG_BUFFER_BINARY;
+  bool           MSG_TASK_PROFILING_ENABLE;
 } loc_logger_s_type;
 
 
@@ -159,10 +161,20 @@ inline void loc_logger_init(unsigned long debug, unsigned long timestamp)
 inline void log_buffer_init(bool enabled) {
     loc_logger.LOG_BUFFER_ENABLE = enabled;
 }
+
+inline void log_buffer_binary_init(bool enabled) {
+    loc_logger.LOG_BUFFER_BINARY = enabled;
+}
+
+inline void msg_task_profiling_init(bool enabled) {
+    loc_logger.MSG_TASK_PROFILING_ENABLE = enabled;
+}
 extern void log_tag_level_map_init();
 extern int get_tag_log_level(const char* tag);
+extern int log_tag_level_resolve(int** slot, const char* tag);
 extern char* get_timestamp(char* str, unsigned long buf_size);
 extern void log_buffer_insert(char *str, unsigned long buf_size, int level);
+extern void log_buffer_insert_binary(const char *rec, unsigned long len, int level);
 /*=============================================================================
  *
  *                          LOGGING BUFFER MACROS
@@ -174,10 +186,23 @@ extern void log_buffer_insert(char *str, unsigned long buf_size, int level);
 #define TOTAL_LOG_LEVELS 5
 #define LOGGING_BUFFER_MAX_LEN 1024
 #define IF_LOG_BUFFER_ENABLE if (loc_logger.LOG_BUFFER_ENABLE)
+#ifdef __cplusplus
+#define IF_LOG_BUFFER_BINARY if (loc_logger.LOG_BUFFER_BINARY)
+#define INSERT_BUFFER_BINARY(level, format, x...)                                             \
+    loc_util::log_buffer_insert_args(level, LOG_TAG, format, ##x)
+#else
+/* C sources always insert formatted lines */
+#define IF_LOG_BUFFER_BINARY if (0)
+#define INSERT_BUFFER_BINARY(level, format, x...)
+#endif
 #define INSERT_BUFFER(flag, level, format, x...)                                              \
 {                                                                                             \
     IF_LOG_BUFFER_ENABLE {                                                                    \
-        if (flag == 0) {                                                                      \
+        IF_LOG_BUFFER_BINARY {                                                                \
+            if (flag == 0) {                                                                  \
+                INSERT_BUFFER_BINARY(level, format, ##x);                                     \
+            }                                                                                 \
+        } else if (flag == 0) {                                                               \
             char timestr[32];                                                                 \
             get_timestamp(timestr, sizeof(timestr));                                          \
             char log_str[LOGGING_BUFFER_MAX_LEN];                                             \
@@ -202,15 +227,22 @@ extern void log_buffer_insert(char *str, unsigned long buf_size, int level);
  * 1, LOCAL_LOG_LEVEL is defined as a static variable in log_util.h,
  *    then all source files which includes log_util.h will have its own LOCAL_LOG_LEVEL variable;
  * 2, For each source file,
- *    2.1, First time when LOC_LOG* is invoked(its LOCAL_LOG_LEVEL == -1),
- *         Set the tag based log level according to the <tag, level> map;
- *         If this tag isn't found in map, set local debug level as global loc_logger.DEBUG_LEVEL;
- *    2.2, If not the first time, use its LOCAL_LOG_LEVEL as the debug level of this tag.
+ *    2.1, First time when LOC_LOG* is invoked(its LOCAL_LOG_LEVEL == NULL),
+ *         Point LOCAL_LOG_LEVEL to the level slot of its tag, which loc_log.cpp keeps per tag,
+ *         holding the tag based log level according to the <tag, level> map;
+ *         If this tag isn't found in map, the slot holds the global loc_logger.DEBUG_LEVEL;
+ *    2.2, If not the first time, a relaxed load from the slot is the debug level of this tag.
+ *         The slots are updated in place when gps.conf is read again.
 */
-static int LOCAL_LOG_LEVEL = -1;
-#define IF_LOC_LOG(x) \
-    if (((LOCAL_LOG_LEVEL == -1 && (LOCAL_LOG_LEVEL = get_tag_log_level(LOG_TAG)) >= x) ||\
-            LOCAL_LOG_LEVEL >= x) && LOCAL_LOG_LEVEL <= 5)
+static int* LOCAL_LOG_LEVEL = NULL;
+static inline bool loc_log_enabled(int** slot, const char* tag, int x)
+{
+    int* levelSlot = __atomic_load_n(slot, __ATOMIC_RELAXED);
+    int level = (NULL != levelSlot) ? __atomic_load_n(levelSlot, __ATOMIC_RELAXED) :
+            log_tag_level_resolve(slot, tag);
+    return level >= x && level <= 5;
+}
+#define IF_LOC_LOG(x) if (loc_log_enabled(&LOCAL_LOG_LEVEL, LOG_TAG, x))
 
 #define IF_LOC_LOGE IF_LOC_LOG(1)
 #define IF_LOC_LOGW IF_LOC_LOG(2)
@@ -288,4 +320,193 @@ static int LOCAL_LOG_LEVEL = -1;
 }
 #endif
 
+#ifdef __cplusplus
+#include <sys/time.h>
+#include <type_traits>
+#include <algorithm>
+#include <stdint.h>
+
+namespace loc_util {
+
+/*=============================================================================
+ *
+ *                          BINARY LOG BUFFER RECORDS
+ *
+ *============================================================================*/
+/* With LOG_BUFFER_BINARY, LOC_LOG* lines go into the log buffer as the
+   tag and format strings plus the raw arguments, and are only formatted when
+   the buffer is dumped, so records decode offline as well. Each argument is
+   classified by the conversion it is for in the format, with the width of
+   its C++ type; only pointers for a %s are copied as strings. */
+enum LocLogArgType : uint8_t {
+    LOC_LOG_ARG_INT = 1,   // integers up to 32 bits, passed on as int
+    LOC_LOG_ARG_INT64,     // 64 bit integers, passed on as long long
+    LOC_LOG_ARG_DOUBLE,
+    LOC_LOG_ARG_PTR,       // 64 bits whatever the pointer size of the process
+    LOC_LOG_ARG_STR,       // uint16_t length, then the chars without NUL
+};
+
+struct LocLogBinHead {
+    int64_t mSec;
+    int32_t mUsec;
+    int32_t mPid;
+    int64_t mTid;
+    // the tag then the format follow the head, without NUL
+    uint16_t mTagLen;
+    uint16_t mFormatLen;
+};
+
+class LocLogBinWriter {
+    char* mPos;
+    char* const mEnd;
+    // the rest of the format after the conversions taken so far
+    const char* mFormat;
+    const char* const mFormatEnd;
+    char mConv;
+    int mStars;
+    bool mConvPending;
+    inline void putRaw(uint8_t type, const void* val, size_t len) {
+        if (mPos + 1 + len <= mEnd) {
+            *mPos++ = type;
+            memcpy(mPos, val, len);
+            mPos += len;
+        } else {
+            mPos = mEnd;
+        }
+    }
+    // moves to the next conversion of the format, counting its '*'
+    inline char scanConv() {
+        for (const char* f = mFormat; f < mFormatEnd; f++) {
+            if ('%' != *f) {
+                continue;
+            }
+            if (f + 1 < mFormatEnd && '%' == f[1]) {
+                f++;
+                continue;
+            }
+            const char* c = f + 1;
+            while (c < mFormatEnd && nullptr != strchr("-+ #0123456789.*hlLqjzt", *c)) {
+                mStars += ('*' == *c);
+                c++;
+            }
+            if (c < mFormatEnd) {
+                mFormat = c + 1;
+                return *c;
+            }
+            break;
+        }
+        mFormat = mFormatEnd;
+        return '\0';
+    }
+    // the conversion the next argument is for, '*' for a width or precision
+    inline char nextConv() {
+        if (!mConvPending) {
+            mStars = 0;
+            mConv = scanConv();
+            mConvPending = true;
+        }
+        if (mStars > 0) {
+            mStars--;
+            return '*';
+        }
+        mConvPending = false;
+        return mConv;
+    }
+    inline void putStr(const char* str) {
+        if (nullptr == str) {
+            str = "(null)";
+        }
+        uint16_t len = 0;
+        if (mPos + 1 + sizeof(len) > mEnd) {
+            mPos = mEnd;
+            return;
+        }
+        // truncated to what is left of the record
+        len = (uint16_t)strnlen(str, mEnd - mPos - 1 - sizeof(len));
+        putRaw(LOC_LOG_ARG_STR, &len, sizeof(len));
+        memcpy(mPos, str, len);
+        mPos += len;
+    }
+    inline void putPtr(const void* ptr) {
+        uint64_t v = (uint64_t)(uintptr_t)ptr;
+        putRaw(LOC_LOG_ARG_PTR, &v, sizeof(v));
+    }
+public:
+    inline LocLogBinWriter(char* buf, size_t size, const char* format, size_t formatLen):
+            mPos(buf), mEnd(buf + size), mFormat(format), mFormatEnd(format + formatLen),
+            mConv('\0'), mStars(0), mConvPending(false) {}
+    template <typename T>
+    inline typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value>::type
+            put(T val) {
+        nextConv();
+        if (sizeof(T) <= sizeof(int32_t)) {
+            int32_t v = (int32_t)val;
+            putRaw(LOC_LOG_ARG_INT, &v, sizeof(v));
+        } else {
+            int64_t v = (int64_t)val;
+            putRaw(LOC_LOG_ARG_INT64, &v, sizeof(v));
+        }
+    }
+    inline void put(double val) {
+        nextConv();
+        putRaw(LOC_LOG_ARG_DOUBLE, &val, sizeof(val));
+    }
+    // a char pointer is only a string for a %s, e.g. a %p of a buffer keeps
+    // the address
+    inline void put(const char* str) {
+        if ('s' == nextConv()) {
+            putStr(str);
+        } else {
+            putPtr(str);
+        }
+    }
+    inline void put(char* str) { put((const char*)str); }
+    inline void put(const void* ptr) {
+        nextConv();
+        putPtr(ptr);
+    }
+    template <typename R, typename... A>
+    inline void put(R (*fn)(A...)) { put(reinterpret_cast<const void*>(fn)); }
+    // copies chars without NUL, returns how many fit
+    inline uint16_t putChars(const char* str, size_t len) {
+        len = std::min(len, (size_t)std::min<ptrdiff_t>(mEnd - mPos, UINT16_MAX));
+        memcpy(mPos, str, len);
+        mPos += len;
+        return (uint16_t)len;
+    }
+    inline char* pos() { return mPos; }
+    inline void advance(size_t len) { mPos += len; }
+};
+
+inline void log_buffer_put_args(LocLogBinWriter&) {}
+template <typename T, typename... Args>
+inline void log_buffer_put_args(LocLogBinWriter& w, T val, Args... args) {
+    w.put(val);
+    log_buffer_put_args(w, args...);
+}
+
+/* format only binds to string literals, so its length is known at compile
+   time and copying it costs no scan */
+template <size_t N, typename... Args>
+inline void log_buffer_insert_args(int level, const char* tag, const char (&format)[N],
+                                   Args... args) {
+    alignas(LocLogBinHead) char rec[LOGGING_BUFFER_MAX_LEN];
+    LocLogBinWriter w(rec, sizeof(rec), format, N - 1);
+    LocLogBinHead* head = (LocLogBinHead*)w.pos();
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    head->mSec = tv.tv_sec;
+    head->mUsec = tv.tv_usec;
+    head->mPid = getpid();
+    head->mTid = syscall(SYS_gettid);
+    w.advance(sizeof(LocLogBinHead));
+    head->mTagLen = (nullptr == tag) ? 0 : w.putChars(tag, strlen(tag));
+    head->mFormatLen = w.putChars(format, N - 1);
+    log_buffer_put_args(w, args...);
+    log_buffer_insert_binary(rec, w.pos() - rec, level);
+}
+
+} // namespace loc_util
+#endif // __cplusplus
+
 #endif // __LOG_UTIL_H__
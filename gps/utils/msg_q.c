@@ -31,17 +31,47 @@
 #define LOG_TAG "LocSvc_utils_q"
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <limits.h>
 #include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
 #include <loc_pla.h>
 #include <log_util.h>
 #include "linked_list.h"
 #include "msg_q.h"
 
+/* Ring positions are free running 32 bit counters that are meant to wrap */
+#if defined(__clang__)
+#define MSG_Q_WRAPS __attribute__((no_sanitize("unsigned-integer-overflow")))
+#else
+#define MSG_Q_WRAPS
+#endif
+
+typedef struct msg_q_ring_slot {
+   atomic_uint seq;                 /* Slot turn, see msg_q_ring_push/msg_q_ring_pop */
+   void* msg_obj;
+   void (*dealloc)(void*);
+} msg_q_ring_slot;
+
 typedef struct msg_q {
    void* msg_list;                  /* Linked list to store information */
    pthread_cond_t  list_cond;       /* Condition variable for waiting on msg queue */
    pthread_mutex_t list_mutex;      /* Mutex for exclusive access to message queue */
-   int unblocked;                   /* Has this message queue been unblocked? */
+   atomic_int unblocked;            /* Has this message queue been unblocked? */
+   /* Optional bounded ring, NULL for a list only queue. When present, senders
+      go through the ring lock free and only fall back to msg_list (under
+      list_mutex) when the ring is full, or while earlier overflowed messages
+      are still pending in the list, so that FIFO order is kept. */
+   msg_q_ring_slot* ring;
+   uint32_t ring_mask;
+   atomic_uint ring_head;           /* Next slot to be received */
+   atomic_uint ring_tail;           /* Next slot to be sent to */
+   atomic_uint list_count;          /* Number of overflowed msgs in msg_list */
+   atomic_uint wake_seq;            /* futex word, bumped on every send / unblock */
+   atomic_uint waiting;             /* Receiver is about to park on wake_seq */
 } msg_q;
 
 /*===========================================================================
@@ -83,6 +113,173 @@ static msq_q_err_type convert_linked_list_err_type(linked_list_err_type linked_l
    }
 }
 
+/*===========================================================================
+FUNCTION    msg_q_ring_push
+
+DESCRIPTION
+   Lock free multi-producer enqueue into the bounded ring. Each slot carries
+   a turn counter; a sender claims the tail slot whose turn equals the tail
+   position, fills it and publishes it by advancing the turn.
+
+RETURN VALUE
+   1 if the msg was queued; 0 if the ring is full
+
+===========================================================================*/
+MSG_Q_WRAPS static int msg_q_ring_push(msg_q* p_msg_q, void* msg_obj, void (*dealloc)(void*))
+{
+   msg_q_ring_slot* slot;
+   unsigned int pos = atomic_load_explicit(&p_msg_q->ring_tail, memory_order_relaxed);
+
+   for (;;) {
+      slot = &p_msg_q->ring[pos & p_msg_q->ring_mask];
+      unsigned int seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+      int diff = (int)(seq - pos);
+      if (0 == diff) {
+         if (atomic_compare_exchange_weak_explicit(&p_msg_q->ring_tail, &pos, pos + 1,
+                                                   memory_order_relaxed,
+                                                   memory_order_relaxed)) {
+            break;
+         }
+      } else if (diff < 0) {
+         return 0;
+      } else {
+         pos = atomic_load_explicit(&p_msg_q->ring_tail, memory_order_relaxed);
+      }
+   }
+
+   slot->msg_obj = msg_obj;
+   slot->dealloc = dealloc;
+   atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+   return 1;
+}
+
+/*===========================================================================
+FUNCTION    msg_q_ring_pop
+
+DESCRIPTION
+   Dequeue the oldest published msg from the ring. Safe against concurrent
+   senders; receivers may also race each other (e.g. flush vs. rcv).
+
+RETURN VALUE
+   1 if a msg was dequeued; 0 if the ring is empty
+
+===========================================================================*/
+MSG_Q_WRAPS static int msg_q_ring_pop(msg_q* p_msg_q, void** msg_obj, void (**dealloc)(void*))
+{
+   msg_q_ring_slot* slot;
+   unsigned int pos = atomic_load_explicit(&p_msg_q->ring_head, memory_order_relaxed);
+
+   for (;;) {
+      slot = &p_msg_q->ring[pos & p_msg_q->ring_mask];
+      unsigned int seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+      int diff = (int)(seq - (pos + 1));
+      if (0 == diff) {
+         if (atomic_compare_exchange_weak_explicit(&p_msg_q->ring_head, &pos, pos + 1,
+                                                   memory_order_relaxed,
+                                                   memory_order_relaxed)) {
+            break;
+         }
+      } else if (diff < 0) {
+         return 0;
+      } else {
+         pos = atomic_load_explicit(&p_msg_q->ring_head, memory_order_relaxed);
+      }
+   }
+
+   *msg_obj = slot->msg_obj;
+   if (dealloc != NULL) {
+      *dealloc = slot->dealloc;
+   }
+   atomic_store_explicit(&slot->seq, pos + p_msg_q->ring_mask + 1, memory_order_release);
+   return 1;
+}
+
+/*===========================================================================
+FUNCTION    msg_q_ring_has_data
+
+DESCRIPTION
+   Checks, without dequeuing, if a msg is ready either in the ring or in
+   the overflow list.
+
+===========================================================================*/
+MSG_Q_WRAPS static int msg_q_ring_has_data(msg_q* p_msg_q)
+{
+   unsigned int pos = atomic_load_explicit(&p_msg_q->ring_head, memory_order_relaxed);
+   msg_q_ring_slot* slot = &p_msg_q->ring[pos & p_msg_q->ring_mask];
+
+   return (atomic_load_explicit(&slot->seq, memory_order_acquire) == pos + 1) ||
+          (atomic_load(&p_msg_q->list_count) > 0);
+}
+
+/*===========================================================================
+FUNCTION    msg_q_ring_wake
+
+DESCRIPTION
+   Bumps the futex word and wakes up a parked receiver, if there is one.
+   The syscall is only made when the receiver has announced that it is
+   going to sleep.
+
+===========================================================================*/
+static void msg_q_ring_wake(msg_q* p_msg_q, int nr_wake)
+{
+   atomic_fetch_add(&p_msg_q->wake_seq, 1);
+   if (atomic_load(&p_msg_q->waiting)) {
+      syscall(SYS_futex, &p_msg_q->wake_seq, FUTEX_WAKE_PRIVATE, nr_wake, NULL, NULL, 0);
+   }
+}
+
+/*===========================================================================
+FUNCTION    msg_q_ring_rcv
+
+DESCRIPTION
+   Receive path for a queue created with a ring. The ring is drained before
+   the overflow list, which matches the order senders used them in. When
+   block is set, the receiver parks on the wake_seq futex until a sender or
+   msg_q_unblock bumps it.
+
+===========================================================================*/
+static msq_q_err_type msg_q_ring_rcv(msg_q* p_msg_q, void** msg_obj, int block)
+{
+   for (;;) {
+      if (atomic_load(&p_msg_q->unblocked)) {
+         LOC_LOGE("%s: Message queue has been unblocked.\n", __FUNCTION__);
+         return eMSG_Q_UNAVAILABLE_RESOURCE;
+      }
+
+      if (msg_q_ring_pop(p_msg_q, msg_obj, NULL)) {
+         return eMSG_Q_SUCCESS;
+      }
+
+      if (atomic_load(&p_msg_q->list_count) > 0) {
+         msq_q_err_type rv;
+         pthread_mutex_lock(&p_msg_q->list_mutex);
+         rv = convert_linked_list_err_type(linked_list_remove(p_msg_q->msg_list, msg_obj));
+         if (eMSG_Q_SUCCESS == rv) {
+            atomic_fetch_sub(&p_msg_q->list_count, 1);
+         }
+         pthread_mutex_unlock(&p_msg_q->list_mutex);
+         if (eMSG_Q_SUCCESS == rv) {
+            return rv;
+         }
+      }
+
+      if (!block) {
+         LOC_LOGV("%s: list is empty !!\n", __FUNCTION__);
+         return (msq_q_err_type)eLINKED_LIST_EMPTY;
+      }
+
+      /* Announce the wait before sampling the futex word, then check again;
+         a sender that published after the check has bumped wake_seq, so
+         FUTEX_WAIT returns right away instead of missing the wake up. */
+      atomic_store(&p_msg_q->waiting, 1);
+      unsigned int seq = atomic_load(&p_msg_q->wake_seq);
+      if (!msg_q_ring_has_data(p_msg_q) && !atomic_load(&p_msg_q->unblocked)) {
+         syscall(SYS_futex, &p_msg_q->wake_seq, FUTEX_WAIT_PRIVATE, seq, NULL, NULL, 0);
+      }
+      atomic_store(&p_msg_q->waiting, 0);
+   }
+}
+
 /* ----------------------- END INTERNAL FUNCTIONS ---------------------------------------- */
 
 /*===========================================================================
@@ -91,6 +288,16 @@ static msq_q_err_type convert_linked_list_err_type(linked_list_err_type linked_l
 
   ===========================================================================*/
 msq_q_err_type msg_q_init(void** msg_q_data)
+{
+   return msg_q_init_ring(msg_q_data, 0);
+}
+
+/*===========================================================================
+
+  FUNCTION:   msg_q_init_ring
+
+  ===========================================================================*/
+msq_q_err_type msg_q_init_ring(void** msg_q_data, uint32_t ring_size)
 {
    if( msg_q_data == NULL )
    {
@@ -131,6 +338,39 @@ msq_q_err_type msg_q_init(void** msg_q_data)
    }
 
    tmp_msg_q->unblocked = 0;
+   tmp_msg_q->ring = NULL;
+
+   if( ring_size > 0 )
+   {
+      uint32_t size = 1;
+      uint32_t i;
+      while( size < ring_size && size < MSG_Q_RING_SIZE_MAX )
+      {
+         size <<= 1;
+      }
+
+      tmp_msg_q->ring = (msg_q_ring_slot*)calloc(size, sizeof(msg_q_ring_slot));
+      if( tmp_msg_q->ring == NULL )
+      {
+         LOC_LOGE("%s: Unable to allocate msg q ring of %u!\n", __FUNCTION__, size);
+         linked_list_destroy(&tmp_msg_q->msg_list);
+         pthread_mutex_destroy(&tmp_msg_q->list_mutex);
+         pthread_cond_destroy(&tmp_msg_q->list_cond);
+         free(tmp_msg_q);
+         return eMSG_Q_FAILURE_GENERAL;
+      }
+
+      for( i = 0; i < size; i++ )
+      {
+         atomic_init(&tmp_msg_q->ring[i].seq, i);
+      }
+      tmp_msg_q->ring_mask = size - 1;
+      atomic_init(&tmp_msg_q->ring_head, 0);
+      atomic_init(&tmp_msg_q->ring_tail, 0);
+      atomic_init(&tmp_msg_q->list_count, 0);
+      atomic_init(&tmp_msg_q->wake_seq, 0);
+      atomic_init(&tmp_msg_q->waiting, 0);
+   }
 
    *msg_q_data = tmp_msg_q;
 
@@ -151,6 +391,20 @@ const void* msg_q_init2()
   return q;
 }
 
+/*===========================================================================
+
+  FUNCTION:   msg_q_init2_ring
+
+  ===========================================================================*/
+const void* msg_q_init2_ring(uint32_t ring_size)
+{
+  void* q = NULL;
+  if (eMSG_Q_SUCCESS != msg_q_init_ring(&q, ring_size)) {
+    q = NULL;
+  }
+  return q;
+}
+
 /*===========================================================================
 
   FUNCTION:   msg_q_destroy
@@ -169,6 +423,8 @@ msq_q_err_type msg_q_destroy(void** msg_q_data)
    linked_list_destroy(&p_msg_q->msg_list);
    pthread_mutex_destroy(&p_msg_q->list_mutex);
    pthread_cond_destroy(&p_msg_q->list_cond);
+   free(p_msg_q->ring);
+   p_msg_q->ring = NULL;
 
    p_msg_q->unblocked = 0;
 
@@ -199,6 +455,42 @@ msq_q_err_type msg_q_snd(void* msg_q_data, void* msg_obj, void (*dealloc)(void*)
 
    msg_q* p_msg_q = (msg_q*)msg_q_data;
 
+   if( p_msg_q->ring != NULL )
+   {
+      LOC_LOGV("%s: Sending message with handle = %p\n", __FUNCTION__, msg_obj);
+
+      if( atomic_load(&p_msg_q->unblocked) )
+      {
+         LOC_LOGE("%s: Message queue has been unblocked.\n", __FUNCTION__);
+         return eMSG_Q_UNAVAILABLE_RESOURCE;
+      }
+
+      /* Once anything overflowed into the list, keep using the list until
+         the receiver has drained it, otherwise newer msgs would be
+         received ahead of the overflowed ones. */
+      if( atomic_load(&p_msg_q->list_count) > 0 ||
+          !msg_q_ring_push(p_msg_q, msg_obj, dealloc) )
+      {
+         pthread_mutex_lock(&p_msg_q->list_mutex);
+         rv = convert_linked_list_err_type(linked_list_add(p_msg_q->msg_list, msg_obj, dealloc));
+         if( eMSG_Q_SUCCESS == rv )
+         {
+            atomic_fetch_add(&p_msg_q->list_count, 1);
+         }
+         pthread_mutex_unlock(&p_msg_q->list_mutex);
+      }
+      else
+      {
+         rv = eMSG_Q_SUCCESS;
+      }
+
+      msg_q_ring_wake(p_msg_q, 1);
+
+      LOC_LOGV("%s: Finished Sending message with handle = %p\n", __FUNCTION__, msg_obj);
+
+      return rv;
+   }
+
    pthread_mutex_lock(&p_msg_q->list_mutex);
    LOC_LOGV("%s: Sending message with handle = %p\n", __FUNCTION__, msg_obj);
 
@@ -243,6 +535,13 @@ msq_q_err_type msg_q_rcv(void* msg_q_data, void** msg_obj)
 
    msg_q* p_msg_q = (msg_q*)msg_q_data;
 
+   if( p_msg_q->ring != NULL )
+   {
+      rv = msg_q_ring_rcv(p_msg_q, msg_obj, 1);
+      LOC_LOGV("%s: Received message %p rv = %d\n", __FUNCTION__, *msg_obj, rv);
+      return rv;
+   }
+
    pthread_mutex_lock(&p_msg_q->list_mutex);
 
    if( p_msg_q->unblocked )
@@ -287,6 +586,12 @@ msq_q_err_type msg_q_rmv(void* msg_q_data, void** msg_obj)
 
    msg_q* p_msg_q = (msg_q*)msg_q_data;
 
+   if (p_msg_q->ring != NULL) {
+      rv = msg_q_ring_rcv(p_msg_q, msg_obj, 0);
+      LOC_LOGV("%s: Removed message %p rv = %d\n", __FUNCTION__, *msg_obj, rv);
+      return rv;
+   }
+
    pthread_mutex_lock(&p_msg_q->list_mutex);
 
    if (p_msg_q->unblocked) {
@@ -296,7 +601,7 @@ msq_q_err_type msg_q_rmv(void* msg_q_data, void** msg_obj)
    }
 
    if (linked_list_empty(p_msg_q->msg_list)) {
-      LOC_LOGW("%s: list is empty !!\n", __FUNCTION__);
+      LOC_LOGV("%s: list is empty !!\n", __FUNCTION__);
       pthread_mutex_unlock(&p_msg_q->list_mutex);
       return eLINKED_LIST_EMPTY;
    }
@@ -330,10 +635,28 @@ msq_q_err_type msg_q_flush(void* msg_q_data)
 
    LOC_LOGD("%s: Flushing Message Queue\n", __FUNCTION__);
 
+   if( p_msg_q->ring != NULL )
+   {
+      void* msg_obj;
+      void (*dealloc)(void*);
+      /* Remove all elements from the ring */
+      while( msg_q_ring_pop(p_msg_q, &msg_obj, &dealloc) )
+      {
+         if( dealloc != NULL )
+         {
+            dealloc(msg_obj);
+         }
+      }
+   }
+
    pthread_mutex_lock(&p_msg_q->list_mutex);
 
    /* Remove all elements from the list */
    rv = convert_linked_list_err_type(linked_list_flush(p_msg_q->msg_list));
+   if( p_msg_q->ring != NULL )
+   {
+      atomic_store(&p_msg_q->list_count, 0);
+   }
 
    pthread_mutex_unlock(&p_msg_q->list_mutex);
 
@@ -374,6 +697,11 @@ msq_q_err_type msg_q_unblock(void* msg_q_data)
 
    pthread_mutex_unlock(&p_msg_q->list_mutex);
 
+   if( p_msg_q->ring != NULL )
+   {
+      msg_q_ring_wake(p_msg_q, INT_MAX);
+   }
+
    LOC_LOGD("%s: Message Queue unblocked\n", __FUNCTION__);
 
    return eMSG_Q_SUCCESS;
@@ -34,6 +34,10 @@ extern "C" {
 #endif /* __cplusplus */
 
 #include <stdlib.h>
+#include <stdint.h>
+
+/** Upper bound of the ring size accepted by msg_q_init_ring */
+#define MSG_Q_RING_SIZE_MAX 4096
 
 /** Linked List Return Codes */
 typedef enum
@@ -90,6 +94,52 @@ SIDE EFFECTS
 ===========================================================================*/
 const void* msg_q_init2();
 
+/*===========================================================================
+FUNCTION    msg_q_init_ring
+
+DESCRIPTION
+   Initializes internal structures for a message queue that is backed by a
+   bounded, lock free multi-producer / single-consumer ring. msg_q_snd does
+   not take a mutex or allocate while the ring has room; when it is full,
+   messages overflow into the regular linked list, and FIFO order is kept
+   across the two. The receiver parks on a futex instead of a condition
+   variable. All other msg_q_* functions keep their semantics.
+
+   msg_q_data: pointer to an opaque Q handle to be returned; NULL if fails
+   ring_size:  number of ring slots, rounded up to a power of 2 and capped
+               at MSG_Q_RING_SIZE_MAX. 0 creates a list only queue, same as
+               msg_q_init.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   Look at error codes above.
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+msq_q_err_type msg_q_init_ring(void** msg_q_data, uint32_t ring_size);
+
+/*===========================================================================
+FUNCTION    msg_q_init2_ring
+
+DESCRIPTION
+   Same as msg_q_init_ring.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   opaque handle to the Q created; NULL if create fails
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+const void* msg_q_init2_ring(uint32_t ring_size);
+
 /*===========================================================================
 FUNCTION    msg_q_destroy
 